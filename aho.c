@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "aho.h"
+
+// 转移表按“字节类”压缩：没出现在任何模式里的字节都归到类 0，
+// 这样几千个模式（几万个状态）的完整转移表也只有几 MB
+struct AhoCorasick {
+    int nclass;
+    unsigned char byte_class[256];
+    int nstates;
+    int *delta;            // delta[state * nclass + class]，已补全失败转移
+    unsigned char *accept; // 到达该状态时有模式结束（含经失败链继承的）
+    int *out_len;          // 在该状态结束的最长模式的长度
+    int max_len;
+    int match_empty;       // 模式集中有空串，任何位置都匹配
+};
+
+static int fold(int c, int ignore_case) {
+    return ignore_case ? tolower(c) : c;
+}
+
+AhoCorasick *ac_build(char **patterns, int count, int ignore_case) {
+    AhoCorasick *ac = calloc(1, sizeof(AhoCorasick));
+    if (!ac) return NULL;
+
+    // 1. 字节分类，-i 时大小写字母同属一类
+    size_t total = 1;
+    ac->nclass = 1;
+    for (int i = 0; i < count; i++) {
+        size_t len = strlen(patterns[i]);
+        if (len == 0) ac->match_empty = 1;
+        if ((int)len > ac->max_len) ac->max_len = len;
+        total += len;
+        for (size_t j = 0; j < len; j++) {
+            int c = fold((unsigned char)patterns[i][j], ignore_case);
+            if (ac->byte_class[c] == 0) {
+                ac->byte_class[c] = ac->nclass++;
+            }
+        }
+    }
+    if (ignore_case) {
+        for (int c = 'A'; c <= 'Z'; c++) {
+            ac->byte_class[c] = ac->byte_class[tolower(c)];
+        }
+    }
+
+    // 2. 建字典树：状态数不超过模式总长 + 1
+    int nclass = ac->nclass;
+    ac->delta = calloc(total * nclass, sizeof(int));
+    ac->accept = calloc(total, 1);
+    ac->out_len = calloc(total, sizeof(int));
+    if (!ac->delta || !ac->accept || !ac->out_len) {
+        ac_free(ac);
+        return NULL;
+    }
+    ac->nstates = 1;
+    for (int i = 0; i < count; i++) {
+        int state = 0;
+        int len = 0;
+        for (const char *p = patterns[i]; *p; p++, len++) {
+            int cls = ac->byte_class[(unsigned char)*p];
+            int *next = &ac->delta[state * nclass + cls];
+            if (*next == 0) {
+                *next = ac->nstates++;
+            }
+            state = *next;
+        }
+        ac->accept[state] = 1;
+        if (len > ac->out_len[state]) ac->out_len[state] = len;
+    }
+
+    // 3. 按 BFS 顺序求失败链接，并把缺失的转移补成失败状态的转移
+    int *fail = calloc(ac->nstates, sizeof(int));
+    int *queue = malloc(ac->nstates * sizeof(int));
+    if (!fail || !queue) {
+        free(fail);
+        free(queue);
+        ac_free(ac);
+        return NULL;
+    }
+    int head = 0, tail = 0;
+    for (int c = 0; c < nclass; c++) {
+        int t = ac->delta[c];
+        if (t) queue[tail++] = t;
+    }
+    while (head < tail) {
+        int s = queue[head++];
+        for (int c = 0; c < nclass; c++) {
+            int *slot = &ac->delta[s * nclass + c];
+            int via_fail = ac->delta[fail[s] * nclass + c];
+            if (*slot) {
+                fail[*slot] = via_fail;
+                ac->accept[*slot] |= ac->accept[via_fail];
+                if (ac->out_len[via_fail] > ac->out_len[*slot]) {
+                    ac->out_len[*slot] = ac->out_len[via_fail];
+                }
+                queue[tail++] = *slot;
+            } else {
+                *slot = via_fail;
+            }
+        }
+    }
+    free(fail);
+    free(queue);
+    return ac;
+}
+
+const char *ac_search(const AhoCorasick *ac, const char *text, size_t len) {
+    if (ac->match_empty) return text;
+
+    const unsigned char *p = (const unsigned char *)text;
+    const unsigned char *end = p + len;
+    const int *delta = ac->delta;
+    const unsigned char *byte_class = ac->byte_class;
+    int nclass = ac->nclass;
+    int state = 0;
+    while (p < end) {
+        state = delta[state * nclass + byte_class[*p++]];
+        if (ac->accept[state]) return (const char *)p;
+    }
+    return NULL;
+}
+
+int ac_find(const AhoCorasick *ac, const char *text, size_t len, size_t *start, size_t *end) {
+    const unsigned char *p = (const unsigned char *)text;
+    int nclass = ac->nclass;
+    int state = 0;
+    size_t best_start = 0, best_end = 0;
+    int found = 0;
+    for (size_t i = 0; i < len; i++) {
+        // 之后结束的匹配起点都晚于 i + 1 - max_len，不可能比已找到的更靠左
+        if (found && i + 1 > best_start + ac->max_len) break;
+        state = ac->delta[state * nclass + ac->byte_class[p[i]]];
+        if (!ac->out_len[state]) continue;
+        size_t s = i + 1 - ac->out_len[state];
+        if (!found || s <= best_start) {
+            // 起点相同时后结束的更长
+            best_start = s;
+            best_end = i + 1;
+            found = 1;
+        }
+    }
+    if (ac->match_empty && (!found || best_start > 0)) {
+        // 空模式在开头就能匹配，最左的是开头处长度为 0 的匹配
+        best_start = best_end = 0;
+        found = 1;
+    }
+    *start = best_start;
+    *end = best_end;
+    return found;
+}
+
+void ac_free(AhoCorasick *ac) {
+    if (!ac) return;
+    free(ac->delta);
+    free(ac->accept);
+    free(ac->out_len);
+    free(ac);
+}
@@ -0,0 +1,16 @@
+#ifndef AHO_H
+#define AHO_H
+
+#include <stddef.h>
+
+// Aho-Corasick 自动机：一次扫描同时匹配一组固定字符串
+typedef struct AhoCorasick AhoCorasick;
+
+AhoCorasick *ac_build(char **patterns, int count, int ignore_case);
+// 返回第一个匹配的结束位置（最后一个字节之后），没有匹配返回 NULL
+const char *ac_search(const AhoCorasick *ac, const char *text, size_t len);
+// 最左最长匹配的 [*start, *end)，没有匹配返回 0
+int ac_find(const AhoCorasick *ac, const char *text, size_t len, size_t *start, size_t *end);
+void ac_free(AhoCorasick *ac);
+
+#endif
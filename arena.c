@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+struct ArenaBlock {
+    ArenaBlock *next;
+    size_t size;
+    size_t used;
+    char data[];
+};
+
+void arena_init(Arena *a) {
+    a->head = NULL;
+}
+
+static ArenaBlock *new_block(size_t size, ArenaBlock *next) {
+    ArenaBlock *b = malloc(sizeof(ArenaBlock) + size);
+    if (!b) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    b->next = next;
+    b->size = size;
+    b->used = 0;
+    return b;
+}
+
+void *arena_alloc(Arena *a, size_t size) {
+    size = (size + 7) & ~(size_t)7;
+    ArenaBlock *b = a->head;
+    if (!b || b->size - b->used < size) {
+        // 超过一块大小的（很长的行）单独开一块
+        b = new_block(size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE, a->head);
+        a->head = b;
+    }
+    void *p = b->data + b->used;
+    b->used += size;
+    return p;
+}
+
+char *arena_strndup(Arena *a, const char *s, size_t n) {
+    char *p = arena_alloc(a, n + 1);
+    memcpy(p, s, n);
+    p[n] = '\0';
+    return p;
+}
+
+void arena_reset(Arena *a) {
+    ArenaBlock *keep = a->head;
+    if (!keep) return;
+    for (ArenaBlock *b = keep->next; b; b = b->next) {
+        if (b->size > keep->size) keep = b;
+    }
+    for (ArenaBlock *b = a->head; b; ) {
+        ArenaBlock *next = b->next;
+        if (b != keep) free(b);
+        b = next;
+    }
+    keep->next = NULL;
+    keep->used = 0;
+    a->head = keep;
+}
+
+void arena_free(Arena *a) {
+    while (a->head) {
+        ArenaBlock *next = a->head->next;
+        free(a->head);
+        a->head = next;
+    }
+}
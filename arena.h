@@ -0,0 +1,22 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// 按行使用的内存池：解析一行时的词、参数数组、语法树节点都从这里顺序切出，
+// 执行完整行后一次 arena_reset 全部归还，不逐个 free
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct {
+    ArenaBlock *head;   // 当前在切的块，next 指向更早的块
+} Arena;
+
+void arena_init(Arena *a);
+// 按 8 字节对齐分配，内存不足时直接退出
+void *arena_alloc(Arena *a, size_t size);
+char *arena_strndup(Arena *a, const char *s, size_t n);
+// 保留最大的一块留给下一行复用，其余的释放
+void arena_reset(Arena *a);
+void arena_free(Arena *a);
+
+#endif
@@ -0,0 +1,136 @@
+// 词法分析和语法树构造的吞吐量：生成一段大脚本，分别整段解析和按行解析（shell 实际的用法）
+// 用法：make bench && ./bench/parse_bench [行数] [轮数]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../arena.h"
+#include "../lexer.h"
+#include "../parse.h"
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static const char *words[] = {
+    "ls", "-l", "grep", "-rn", "cat", "src/main.c", "echo", "build/out.log", "*.c",
+    "make", "-j8", "find", ".", "-name", "du", "-sh", "/tmp/work", "test", "run",
+};
+
+// 一行随机命令：引号、转义、管道、重定向、&& || ;、子 shell 和注释都会出现
+static size_t gen_line(char *out, unsigned *seed) {
+    char *p = out;
+    int nword = sizeof(words) / sizeof(words[0]);
+    int pieces = 1 + rand_r(seed) % 4;
+    if (rand_r(seed) % 8 == 0) p += sprintf(p, "( ");
+    for (int i = 0; i < pieces; i++) {
+        int args = 1 + rand_r(seed) % 12;
+        for (int j = 0; j < args; j++) {
+            const char *w = words[rand_r(seed) % nword];
+            switch (rand_r(seed) % 10) {
+            case 0:  p += sprintf(p, "'%s %s' ", w, w); break;
+            case 1:  p += sprintf(p, "\"$HOME/%s\\\"x\" ", w); break;
+            case 2:  p += sprintf(p, "%s\\ %s ", w, w); break;
+            default: p += sprintf(p, "%s ", w); break;
+            }
+        }
+        if (rand_r(seed) % 6 == 0) p += sprintf(p, "> /tmp/out.%d ", i);
+        if (i < pieces - 1) {
+            static const char *ops[] = {"| ", "&& ", "|| ", "; "};
+            p += sprintf(p, "%s", ops[rand_r(seed) % 4]);
+        }
+    }
+    if (out[0] == '(') p += sprintf(p, ") ");
+    if (rand_r(seed) % 10 == 0) p += sprintf(p, "# comment");
+    *p++ = '\n';
+    return p - out;
+}
+
+static double run_lex(const char *script, int rounds) {
+    Arena a;
+    arena_init(&a);
+    double start = now_ms();
+    for (int r = 0; r < rounds; r++) {
+        TokenList list;
+        const char *error;
+        if (lex_line(&a, script, &list, &error) < 0) {
+            fprintf(stderr, "lex: %s\n", error);
+            exit(1);
+        }
+        arena_reset(&a);
+    }
+    double ms = now_ms() - start;
+    arena_free(&a);
+    return ms;
+}
+
+static double run_parse(const char *script, int rounds) {
+    Arena a;
+    arena_init(&a);
+    double start = now_ms();
+    for (int r = 0; r < rounds; r++) {
+        const char *error;
+        if (!parse_line(&a, script, NULL, &error)) {
+            fprintf(stderr, "parse: %s\n", error ? error : "empty");
+            exit(1);
+        }
+        arena_reset(&a);
+    }
+    double ms = now_ms() - start;
+    arena_free(&a);
+    return ms;
+}
+
+// 按行解析：每行之后 arena_reset，与 shell 主循环一致
+static double run_per_line(char **lines, int nlines, int rounds) {
+    Arena a;
+    arena_init(&a);
+    double start = now_ms();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < nlines; i++) {
+            const char *error;
+            if (!parse_line(&a, lines[i], NULL, &error)) {
+                fprintf(stderr, "parse: %s: %s", error ? error : "empty", lines[i]);
+                exit(1);
+            }
+            arena_reset(&a);
+        }
+    }
+    double ms = now_ms() - start;
+    arena_free(&a);
+    return ms;
+}
+
+int main(int argc, char **argv) {
+    int nlines = argc > 1 ? atoi(argv[1]) : 200000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 5;
+    unsigned seed = 12345;
+
+    char *script = malloc((size_t)nlines * 1024);
+    char **lines = malloc(nlines * sizeof(char *));
+    size_t len = 0;
+    for (int i = 0; i < nlines; i++) {
+        size_t n = gen_line(script + len, &seed);
+        lines[i] = strndup(script + len, n);
+        len += n;
+    }
+    script[len] = '\0';
+
+    double mb = len / 1048576.0 * rounds;
+    double lex = run_lex(script, rounds);
+    double parse = run_parse(script, rounds);
+    double per_line = run_per_line(lines, nlines, rounds);
+
+    printf("%d 行，%.1f MB，%d 轮\n", nlines, len / 1048576.0, rounds);
+    printf("%-12s %10s %10s %14s\n", "", "ms/轮", "MB/s", "行/s");
+    printf("%-12s %10.1f %10.1f %14.0f\n", "lex", lex / rounds, mb / (lex / 1000), nlines * (double)rounds / (lex / 1000));
+    printf("%-12s %10.1f %10.1f %14.0f\n", "lex+parse", parse / rounds, mb / (parse / 1000), nlines * (double)rounds / (parse / 1000));
+    printf("%-12s %10.1f %10.1f %14.0f\n", "per-line", per_line / rounds, mb / (per_line / 1000), nlines * (double)rounds / (per_line / 1000));
+
+    for (int i = 0; i < nlines; i++) free(lines[i]);
+    free(lines);
+    free(script);
+    return 0;
+}
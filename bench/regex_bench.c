@@ -0,0 +1,105 @@
+// 对比内置 lazy DFA 与 glibc regexec 的逐行匹配速度
+// 用法：make bench && ./bench/regex_bench [行数]
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <regex.h>
+#include <time.h>
+#include "../dfa.h"
+
+static const char *levels[] = {"INFO", "DEBUG", "WARN", "ERROR", "TRACE"};
+static const char *words[] = {
+    "connection", "timeout", "request", "user", "session", "cache", "disk", "memory",
+    "socket", "handler", "queue", "worker", "retry", "backend", "upstream", "latency",
+};
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// 生成类似服务日志的文本，每行以 '\n' 结尾
+static char *make_log(long lines, size_t *out_len) {
+    size_t cap = lines * 120 + 1;
+    char *buf = malloc(cap);
+    size_t len = 0;
+    srand(42);
+    for (long i = 0; i < lines; i++) {
+        len += snprintf(buf + len, cap - len, "2024-05-%02d 12:%02d:%02d [%s] %s %s id=%d took %dms\n",
+                        1 + rand() % 28, rand() % 60, rand() % 60, levels[rand() % 5],
+                        words[rand() % 16], words[rand() % 16], rand() % 100000, rand() % 5000);
+    }
+    *out_len = len;
+    return buf;
+}
+
+// 告警规则那种大量 '|' 的模式：alert_0|alert_1|...
+static char *make_alternation(int count) {
+    char *p = malloc(count * 32 + 1);
+    size_t len = 0;
+    for (int i = 0; i < count; i++) {
+        len += sprintf(p + len, "%s(%s|%s) id=%d[0-9]+ ", i ? "|" : "", words[i % 16], words[(i * 7) % 16], i);
+    }
+    return p;
+}
+
+static void run(const char *name, const char *pattern, const char *buf, size_t len) {
+    regex_t re;
+    if (regcomp(&re, pattern, REG_EXTENDED) != 0) {
+        fprintf(stderr, "%s: regcomp failed\n", name);
+        return;
+    }
+    Dfa *dfa = dfa_compile(pattern, 0);
+    if (!dfa) {
+        fprintf(stderr, "%s: pattern not supported by dfa\n", name);
+        regfree(&re);
+        return;
+    }
+
+    long hits[2] = {0, 0};
+    double ms[2];
+    for (int engine = 0; engine < 2; engine++) {
+        double t0 = now_ms();
+        const char *p = buf, *end = buf + len;
+        while (p < end) {
+            const char *nl = memchr(p, '\n', end - p);
+            size_t n = nl - p;
+            int matched;
+            if (engine == 0) {
+                regmatch_t range = {0, (regoff_t)n};
+                matched = regexec(&re, p, 0, &range, REG_STARTEND) == 0;
+            } else {
+                matched = dfa_match(dfa, p, n);
+            }
+            hits[engine] += matched;
+            p = nl + 1;
+        }
+        ms[engine] = now_ms() - t0;
+    }
+    printf("%-14s libc %9.1f ms   dfa %9.1f ms   x%-6.1f %ld lines%s\n", name, ms[0], ms[1],
+           ms[0] / (ms[1] > 0 ? ms[1] : 1), hits[1], hits[0] == hits[1] ? "" : "  MISMATCH");
+    dfa_free(dfa);
+    regfree(&re);
+}
+
+int main(int argc, char **argv) {
+    long lines = argc > 1 ? atol(argv[1]) : 200000;
+    size_t len;
+    char *buf = make_log(lines, &len);
+    char *alt64 = make_alternation(64);
+    char *alt512 = make_alternation(512);
+
+    run("class", "id=[0-9]+ took [0-9]{4}ms", buf, len);
+    run("anchored", "^2024-05-1[0-9] 12:3", buf, len);
+    run("words", "(ERROR|WARN)\\] (disk|memory|socket)", buf, len);
+    run("icase-like", "[Tt][Ii][Mm][Ee][Oo][Uu][Tt]", buf, len);
+    run("alt-64", alt64, buf, len);
+    run("alt-512", alt512, buf, len);
+
+    free(alt64);
+    free(alt512);
+    free(buf);
+    return 0;
+}
@@ -0,0 +1,70 @@
+// 对比 fork + execvp 与 posix_spawn 启动短命令的延迟
+// 用法：make bench && ./bench/spawn_bench [次数] [额外占用的内存 MB]
+// 额外内存模拟 shell 缓存变大后的情形：fork 要复制的页表随之变大，posix_spawn 不受影响
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "../spawn.h"
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// 原来 main.c 的做法：fork 出整个 shell，再在子进程里 exec
+static double run_fork(char **argv, int count) {
+    double start = now_ms();
+    for (int i = 0; i < count; i++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            execvp(argv[0], argv);
+            _exit(127);
+        }
+        waitpid(pid, NULL, 0);
+    }
+    return now_ms() - start;
+}
+
+static double run_spawn(char **argv, int count) {
+    double start = now_ms();
+    for (int i = 0; i < count; i++) {
+        pid_t pid = spawn_command(argv, NULL);
+        if (pid < 0) {
+            perror(argv[0]);
+            exit(1);
+        }
+        waitpid(pid, NULL, 0);
+    }
+    return now_ms() - start;
+}
+
+int main(int argc, char **argv) {
+    int count = argc > 1 ? atoi(argv[1]) : 2000;
+    long heap_mb = argc > 2 ? atol(argv[2]) : 0;
+    char *cmd[] = {"true", NULL};
+
+    printf("%-10s %8s %12s %12s %8s\n", "heap", "runs", "fork+exec", "posix_spawn", "speedup");
+    for (long mb = 0; ; mb = heap_mb) {
+        // 写满每一页，确保页表真的建立起来
+        char *heap = NULL;
+        if (mb > 0) {
+            heap = malloc(mb << 20);
+            memset(heap, 1, mb << 20);
+        }
+        run_spawn(cmd, 10);   // 预热，让 true 进页缓存
+        double f = run_fork(cmd, count);
+        double s = run_spawn(cmd, count);
+        char label[32];
+        snprintf(label, sizeof(label), "%ldMB", mb);
+        printf("%-10s %8d %9.1f us %9.1f us %7.2fx\n", label, count,
+               f * 1000 / count, s * 1000 / count, f / s);
+        free(heap);
+        if (mb == heap_mb) break;
+    }
+    return 0;
+}
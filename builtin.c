@@ -4,462 +4,79 @@
 #include <ctype.h>
 #include <dirent.h>
 #include <unistd.h>
-#include <pwd.h>
-#include <grp.h>
 #include <sys/stat.h>
 #include "builtin.h"
+#include "trigram.h"
+#include "idcache.h"
+#include "cmdhash.h"
 #include <regex.h>
 #include <limits.h>
 #include <fcntl.h>
 #include <sys/stat.h>
 #define MAX_LINE 1024
-#define COLOR_CYAN    "\x1b[36m"
-#define COLOR_RESET   "\x1b[0m"
 char *history[HISTORY_SIZE];
 int history_count = 0;
 Alias aliases[MAX_ALIASES];
 int alias_count = 0;
+int builtin_status = 0;
 
 
-void my_ls(char **args) {
-    int long_format = 0;
-    int start = 1;
-
-    // 检查是否有 -l 参数
-    for (int i = 1; args[i]; i++) {
-        if (strcmp(args[i], "-l") == 0) {
-            long_format = 1;
-            start++;
-        }
-    }
-
-    if (!args[start]) {
-        args[start] = ".";
-        args[start + 1] = NULL;
-    }
-
-    for (int i = start; args[i]; i++) {
-        struct stat st;
-        if (stat(args[i], &st) != 0) {
-            perror(args[i]);
-            continue;
-        }
-
-        // 如果是目录，就列出目录内容
-        if (S_ISDIR(st.st_mode)) {
-            DIR *dir = opendir(args[i]);
-            if (!dir) {
-                perror(args[i]);
-                continue;
-            }
-
-            struct dirent *entry;
-            while ((entry = readdir(dir))) {
-                if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
-                    continue;
-
-                char path[512];
-                snprintf(path, sizeof(path), "%s/%s", args[i], entry->d_name);
-
-                if (!long_format) {
-                    printf("%s  ", entry->d_name);
-                } else {
-                    struct stat entry_stat;
-                    if (stat(path, &entry_stat) == 0) {
-                        struct passwd *pw = getpwuid(entry_stat.st_uid);
-                        struct group  *gr = getgrgid(entry_stat.st_gid);
-                        printf("%c%c%c%c%c%c%c%c%c%c %3ld %-8s %-8s %8ld %s\n",
-                            S_ISDIR(entry_stat.st_mode) ? 'd' : '-',
-                            entry_stat.st_mode & S_IRUSR ? 'r' : '-',
-                            entry_stat.st_mode & S_IWUSR ? 'w' : '-',
-                            entry_stat.st_mode & S_IXUSR ? 'x' : '-',
-                            entry_stat.st_mode & S_IRGRP ? 'r' : '-',
-                            entry_stat.st_mode & S_IWGRP ? 'w' : '-',
-                            entry_stat.st_mode & S_IXGRP ? 'x' : '-',
-                            entry_stat.st_mode & S_IROTH ? 'r' : '-',
-                            entry_stat.st_mode & S_IWOTH ? 'w' : '-',
-                            entry_stat.st_mode & S_IXOTH ? 'x' : '-',
-                            (long)entry_stat.st_nlink,
-                            pw->pw_name,
-                            gr->gr_name,
-                            (long)entry_stat.st_size,
-                            entry->d_name
-                        );
-                    }
-                }
-            }
-
-            closedir(dir);
-            //if (!long_format) printf("\n");
-
-        } else {
-            // 普通文件直接打印
-            if (!long_format) {
-                printf("%s  ", args[i]);
-            } else {
-                struct passwd *pw = getpwuid(st.st_uid);
-                struct group  *gr = getgrgid(st.st_gid);
-                printf("%c%c%c%c%c%c%c%c%c%c %3ld %-8s %-8s %8ld %s\n",
-                    S_ISDIR(st.st_mode) ? 'd' : '-',
-                    st.st_mode & S_IRUSR ? 'r' : '-',
-                    st.st_mode & S_IWUSR ? 'w' : '-',
-                    st.st_mode & S_IXUSR ? 'x' : '-',
-                    st.st_mode & S_IRGRP ? 'r' : '-',
-                    st.st_mode & S_IWGRP ? 'w' : '-',
-                    st.st_mode & S_IXGRP ? 'x' : '-',
-                    st.st_mode & S_IROTH ? 'r' : '-',
-                    st.st_mode & S_IWOTH ? 'w' : '-',
-                    st.st_mode & S_IXOTH ? 'x' : '-',
-                    (long)st.st_nlink,
-                    pw->pw_name,
-                    gr->gr_name,
-                    (long)st.st_size,
-                    args[i]
-                );
-            }
-        }
-    }
-    if (!long_format) printf("\n");
-}
-
-void my_cd(char **args) {
+int my_cd(char **args) {
     if (!args[1]) {
         fprintf(stderr, "cd: missing directory\n");
-        return;
+        return 1;
     }
     if (chdir(args[1]) != 0) {
         perror("cd");
+        return 1;
     }
+    return 0;
 }
 
-void my_cat(char **args) {
-    int show_line_numbers = 0;
-    int start_index = 1;
-
-    if (args[1] && strcmp(args[1], "-n") == 0) {
-        show_line_numbers = 1;
-        start_index = 2;
-    }
-
-    //  若无参数（如 cat 或 cat < file），从标准输入读取
-    if (!args[start_index]) {
-        char line[1024];
-        int line_num = 1;
-
-        while (fgets(line, sizeof(line), stdin)) {
-            if (show_line_numbers) {
-                printf("%6d  %s", line_num++, line);
-            } else {
-                fputs(line, stdout);
-            }
-        }
-        return;
-    }
-
-    // 否则逐个读取文件
-    for (int i = start_index; args[i]; i++) {
-        FILE *fp = fopen(args[i], "r");
-        if (!fp) {
-            perror(args[i]);
-            continue;
-        }
-
-        char line[1024];
-        int line_num = 1;
-
-        while (fgets(line, sizeof(line), fp)) {
-            if (show_line_numbers) {
-                printf("%6d  %s", line_num++, line);
-            } else {
-                fputs(line, stdout);
-            }
-        }
-
-        fclose(fp);
-    }
-}
-
+// $VAR 已在切词时按引号规则展开（见 lexer.c），这里只处理转义字符
 void my_echo(char **args) {
     for (int i = 1; args[i]; i++) {
-        if (args[i][0] == '$') {
-            char *env = getenv(args[i] + 1);
-            if (env) printf("%s ", env);
-        } else {
-            // 处理转义字符
-            char *str = args[i];
-            while (*str) {
-                if (*str == '\\') {
-                    str++; // 跳过反斜杠
-                    switch (*str) {
-                        case 'n':  putchar('\n'); break;
-                        case 't':  putchar('\t'); break;
-                        case '\\': putchar('\\'); break;
-                        case 'b':  putchar('\b'); break;
-                        default:   //putchar('\\'); // 如果不是已知转义字符，不输出反斜杠
-                                  putchar(*str);  // 和后面的字符
-                                  break;
-                    }
-                    if (*str) str++; // 如果还有字符，继续处理
-                } else {
-                    putchar(*str++);
+        // 处理转义字符
+        char *str = args[i];
+        while (*str) {
+            if (*str == '\\') {
+                str++; // 跳过反斜杠
+                switch (*str) {
+                    case 'n':  putchar('\n'); break;
+                    case 't':  putchar('\t'); break;
+                    case '\\': putchar('\\'); break;
+                    case 'b':  putchar('\b'); break;
+                    default:   //putchar('\\'); // 如果不是已知转义字符，不输出反斜杠
+                              putchar(*str);  // 和后面的字符
+                              break;
                 }
+                if (*str) str++; // 如果还有字符，继续处理
+            } else {
+                putchar(*str++);
             }
-            printf(" ");
         }
+        printf(" ");
     }
     printf("\n");
 }
 
-void my_grep(char **args) {
-    // 初始化选项变量
-    int ignore_case = 0;
-    int invert_match = 0;
-    int line_number = 0;
-    int count_only = 0;
-    int recursive = 0;
-    int files_with_matches = 0;
-    int only_matching = 0;
-    int extended_regex = 0;
-    int after_context = 0;
-    int before_context = 0;
-    int context_lines = 0;
-    
-    char *pattern = NULL;
-    int pattern_found = 0;
-    int file_args_start = 0;
-    
-    // 解析参数
-    for (int i = 1; args[i] != NULL; i++) {
-        if (strcmp(args[i], "-i") == 0) {
-            ignore_case = 1;
-        } else if (strcmp(args[i], "-v") == 0) {
-            invert_match = 1;
-        } else if (strcmp(args[i], "-n") == 0) {
-            line_number = 1;
-        } else if (strcmp(args[i], "-c") == 0) {
-            count_only = 1;
-        } else if (strcmp(args[i], "-r") == 0) {
-            recursive = 1;
-        } else if (strcmp(args[i], "-l") == 0) {
-            files_with_matches = 1;
-        } else if (strcmp(args[i], "-o") == 0) {
-            only_matching = 1;
-        } else if (strcmp(args[i], "-E") == 0) {
-            extended_regex = 1;
-        } else if (strcmp(args[i], "-A") == 0 && args[i+1] != NULL) {
-            after_context = 1;
-            context_lines = atoi(args[i+1]);
-            i++;
-        } else if (strcmp(args[i], "-B") == 0 && args[i+1] != NULL) {
-            before_context = 1;
-            context_lines = atoi(args[i+1]);
-            i++;
-        } else if (args[i][0] != '-' && !pattern_found) {
-            pattern = args[i];
-            pattern_found = 1;
-            file_args_start = i + 1;
-        }
-    }
-    
-    // 检查参数有效性
-    if (!pattern || !args[file_args_start]) {
-        fprintf(stderr, "Usage: grep [-i] [-v] [-n] [-c] [-r] [-l] [-o] [-E] [-A num] [-B num] pattern file...\n");
-        return;
-    }
-    
-    // 处理正则表达式
-    regex_t regex;
-    int reg_flags = REG_EXTENDED | (ignore_case ? REG_ICASE : 0);
-    if (regcomp(&regex, pattern, reg_flags) != 0) {
-        fprintf(stderr, "Invalid regular expression\n");
-        return;
-    }
-    
-    // 处理文件参数
-    for (int i = file_args_start; args[i] != NULL; i++) {
-        process_file_or_dir(args[i], pattern, &regex, 
-                          ignore_case, invert_match, line_number,
-                          count_only, recursive, files_with_matches,
-                          only_matching, extended_regex,
-                          after_context, before_context, context_lines);
-    }
-    
-    regfree(&regex);
-}
-
-// 辅助函数：处理文件或目录
-void process_file_or_dir(const char *path, const char *pattern, regex_t *regex,
-                        int ignore_case, int invert_match, int line_number,
-                        int count_only, int recursive, int files_with_matches,
-                        int only_matching, int extended_regex,
-                        int after_context, int before_context, int context_lines) {
-    struct stat statbuf;
-    if (stat(path, &statbuf) != 0) {
-        perror(path);
-        return;
-    }
-    
-    if (S_ISDIR(statbuf.st_mode)) {
-        if (recursive) {
-            process_directory(path, pattern, regex, 
-                            ignore_case, invert_match, line_number,
-                            count_only, files_with_matches,
-                            only_matching, extended_regex,
-                            after_context, before_context, context_lines);
-        } else {
-            fprintf(stderr, "grep: %s: Is a directory\n", path);
-        }
-    } else {
-        process_file(path, pattern, regex, 
-                    ignore_case, invert_match, line_number,
-                    count_only, files_with_matches,
-                    only_matching, extended_regex,
-                    after_context, before_context, context_lines);
-    }
-}
-
-// 辅助函数：处理目录
-void process_directory(const char *dirpath, const char *pattern, regex_t *regex,
-                      int ignore_case, int invert_match, int line_number,
-                      int count_only, int files_with_matches,
-                      int only_matching, int extended_regex,
-                      int after_context, int before_context, int context_lines) {
-    DIR *dir = opendir(dirpath);
-    if (!dir) {
-        perror(dirpath);
-        return;
-    }
-    
-    struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL) {
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-            continue;
-        }
-        
-        char fullpath[PATH_MAX];
-        snprintf(fullpath, sizeof(fullpath), "%s/%s", dirpath, entry->d_name);
-        
-        process_file_or_dir(fullpath, pattern, regex, 
-                          ignore_case, invert_match, line_number,
-                          count_only, 1, files_with_matches,
-                          only_matching, extended_regex,
-                          after_context, before_context, context_lines);
-    }
-    
-    closedir(dir);
-}
-
-
-void process_file(const char *filename, const char *pattern, regex_t *regex,
-                 int ignore_case, int invert_match, int line_number,
-                 int count_only, int files_with_matches,
-                 int only_matching, int extended_regex,
-                 int after_context, int before_context, int context_lines) {
-    FILE *fp = fopen(filename, "r");
-    if (!fp) {
-        perror(filename);
-        return;
-    }
-
-    char *lines[10000];  // 存所有行
-    int should_print[10000] = {0}; // 标记哪些行要打印
-    int is_match_line[10000] = {0}; // 记录哪些是匹配行
-    int total_lines = 0;
-
-    // 读取所有行
-    char buf[4096];
-    while (fgets(buf, sizeof(buf), fp)) {
-        lines[total_lines] = strdup(buf);
-        total_lines++;
-    }
-    fclose(fp);
-
-    // 第一次遍历：标记匹配行并处理上下文范围
-    int match_count = 0;
-    for (int i = 0; i < total_lines; i++) {
-        int matched = (regexec(regex, lines[i], 0, NULL, 0) == 0);
-        if (invert_match) matched = !matched;
-
-        if (matched) {
-            is_match_line[i] = 1;
-            match_count++;
-
-            int start = before_context ? ((i - context_lines >= 0) ? i - context_lines : 0) : i;
-            int end = after_context ? ((i + context_lines < total_lines) ? i + context_lines : total_lines - 1) : i;
-
-            for (int j = start; j <= end; j++) {
-                should_print[j] = 1;
-            }
-        }
-    }
-
-    // 处理 -l 和 -c
-    if (files_with_matches) {
-        if (match_count > 0) printf("%s\n", filename);
-        goto cleanup;
-    }
-
-    if (count_only) {
-        printf("%s:%d\n", filename, match_count);
-        goto cleanup;
-    }
-
-    // 第二次遍历：输出已标记的行
-    for (int i = 0; i < total_lines; i++) {
-        if (should_print[i]) {
-            print_line(filename, i + 1, lines[i], line_number, is_match_line[i] && only_matching, pattern);
-        }
-    }
-
-cleanup:
-    for (int i = 0; i < total_lines; i++) {
-        free(lines[i]);
-    }
-}
-
-
-
-// 辅助函数：打印一行
-void print_line(const char *filename, int line_num, const char *line, 
-               int show_line_number, int only_matching,const char * pattern) {
-    if (only_matching) {
-        // 这里简化处理，实际需要提取匹配的部分
-        printf("%s\n", line);  // 实际实现需要更复杂的处理
-    } else {
-        char *match_start = strstr(line, pattern);
-        if (match_start) {
-            int prefix_len = match_start - line;
-            int match_len = strlen(pattern);
-            const char *highlight_color = COLOR_CYAN;
-            if (show_line_number) {
-                printf("%s:%d:", filename, line_num);
-            } else {
-                printf("%s:", filename);
-            }
-            
-            // 打印匹配前的部分
-            printf("%.*s", prefix_len, line);
-            
-            // 打印带颜色的匹配部分
-            printf("%s%.*s%s", highlight_color, match_len, match_start, COLOR_RESET);
-            
-            // 打印匹配后的部分
-            printf("%s", match_start + match_len);
-        } else {
-            if (show_line_number) {
-                printf("%s:%d:%s", filename, line_num, line);
-            } else {
-                printf("%s:%s", filename, line);
-            }
-        }
+// 实现index命令：为目录树建立（或增量更新）三元组索引，供 grep -r 缩小候选文件
+int my_index(char **args) {
+    const char *dir = args[1] && args[2] ? args[2] : ".";
+    if (args[1] && strcmp(args[1], "build") == 0) {
+        return tri_build(dir) == 0 ? 0 : 1;
+    } else if (args[1] && strcmp(args[1], "status") == 0) {
+        return tri_status(dir) == 0 ? 0 : 1;
     }
+    fprintf(stderr, "Usage: index build|status [dir]\n");
+    return 1;
 }
 
 // 检查是否为内置命令
 int is_builtin(const char *cmd) {
     const char *builtins[] = {
         "ls", "cd", "cat", "grep", "echo", "history", 
-        "clearhistory", "alias", "unalias", "type", NULL
+        "clearhistory", "alias", "unalias", "type", "index", "du", "find", "hash", NULL
     };
     
     for (int i = 0; builtins[i]; i++) {
@@ -470,35 +87,9 @@ int is_builtin(const char *cmd) {
     return 0;
 }
 
-// 在PATH中查找命令的绝对路径
+// 在PATH中查找命令的绝对路径（经过命令缓存，见 cmdhash.h）
 char *find_command_in_path(const char *cmd) {
-    if (strchr(cmd, '/')) {
-        // 如果包含路径，直接检查文件
-        if (access(cmd, X_OK) == 0) {
-            return strdup(cmd);
-        }
-        return NULL;
-    }
-
-    char *path = getenv("PATH");
-    if (!path) return NULL;
-
-    char *path_copy = strdup(path);
-    char *dir = strtok(path_copy, ":");
-    char *full_path = malloc(PATH_MAX);
-
-    while (dir) {
-        snprintf(full_path, PATH_MAX, "%s/%s", dir, cmd);
-        if (access(full_path, X_OK) == 0) {
-            free(path_copy);
-            return full_path;
-        }
-        dir = strtok(NULL, ":");
-    }
-
-    free(full_path);
-    free(path_copy);
-    return NULL;
+    return cmd_hash_lookup(cmd, 0);
 }
 
 // 实现type命令
@@ -579,8 +170,9 @@ void clear_history() {
 char *get_history_file_path() {
     const char *home = getenv("HOME");
     if (!home) {
-        home = getpwuid(getuid())->pw_dir;
+        home = id_user_home(getuid());
     }
+    if (!home) home = ".";
     char *path = malloc(strlen(home) + 20);
     sprintf(path, "%s/.mysh_history", home);
     return path;
@@ -693,22 +285,19 @@ void load_aliases_from_file() {
     fclose(fp);
 }
 
-int run_builtin(char **args,const char *raw_line) {
+int run_builtin(char **args, const char *input_file, const char *output_file) {
     // 新增：临时保存原始标准输入输出
     int saved_stdin = dup(STDIN_FILENO);
     int saved_stdout = dup(STDOUT_FILENO);
     
-    // 新增：解析重定向
-    char *input_file = NULL;
-    char *output_file = NULL;
-    parse_redirection(args, &input_file, &output_file);
-    compress_args(args);
-    
     // 新增：输入重定向
     if (input_file) {
         int fd = open(input_file, O_RDONLY);
         if (fd < 0) {
             perror("打开输入文件失败");
+            close(saved_stdin);
+            close(saved_stdout);
+            builtin_status = 1;
             return 1;
         }
         dup2(fd, STDIN_FILENO);
@@ -720,6 +309,10 @@ int run_builtin(char **args,const char *raw_line) {
         int fd = open(output_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
         if (fd < 0) {
             perror("创建输出文件失败");
+            dup2(saved_stdin, STDIN_FILENO);
+            close(saved_stdin);
+            close(saved_stdout);
+            builtin_status = 1;
             return 1;
         }
         dup2(fd, STDOUT_FILENO);
@@ -727,7 +320,7 @@ int run_builtin(char **args,const char *raw_line) {
     }
     
     // 执行内置命令
-    int result = handle_builtin(args, raw_line);
+    int result = handle_builtin(args);
     
     // 新增：恢复标准输入输出
     fflush(stdout);
@@ -739,11 +332,12 @@ int run_builtin(char **args,const char *raw_line) {
     return result;
 }
 
-int handle_builtin(char **args, const char *full_line) {
-    if (strcmp(args[0], "ls") == 0) my_ls(args);
-    else if (strcmp(args[0], "cd") == 0) my_cd(args);
-    else if (strcmp(args[0], "cat") == 0) my_cat(args);
-    else if (strcmp(args[0], "grep") == 0) my_grep(args);
+int handle_builtin(char **args) {
+    builtin_status = 0;
+    if (strcmp(args[0], "ls") == 0) builtin_status = my_ls(args);
+    else if (strcmp(args[0], "cd") == 0) builtin_status = my_cd(args);
+    else if (strcmp(args[0], "cat") == 0) builtin_status = my_cat(args);
+    else if (strcmp(args[0], "grep") == 0) builtin_status = my_grep(args);
     else if (strcmp(args[0], "echo") == 0) my_echo(args);
     else if (strcmp(args[0], "history") == 0) {
         if (!args[1]) {
@@ -764,24 +358,19 @@ int handle_builtin(char **args, const char *full_line) {
         if (!args[1]) {
             show_aliases();
         } else {
+            // 引号已由 shell 去掉：alias ll='ls -l' 收到的是 ll=ls -l；
+            // 不加引号写成 alias ll=ls -l 时把后面的参数用空格接回去
             char temp[300];
-            strncpy(temp, full_line, sizeof(temp) - 1);
-            temp[sizeof(temp) - 1] = '\0';
-
-            char *alias_body = strchr(temp, ' ');
-            if (!alias_body) return 1;
-            alias_body++;
+            size_t len = 0;
+            temp[0] = '\0';
+            for (int i = 1; args[i] && len < sizeof(temp) - 1; i++) {
+                len += snprintf(temp + len, sizeof(temp) - len, i > 1 ? " %s" : "%s", args[i]);
+            }
 
-            char *eq = strchr(alias_body, '=');
+            char *eq = strchr(temp, '=');
             if (eq) {
                 *eq = '\0';
-                char *name = alias_body;
-                char *command = eq + 1;
-                if (*command == '\'' || *command == '"') {
-                    command++;
-                    command[strlen(command) - 1] = '\0';
-                }
-                add_alias(name, command);
+                add_alias(temp, eq + 1);
             } else {
                 fprintf(stderr, "alias: invalid format. Usage: alias name='command'\n");
             }
@@ -794,6 +383,14 @@ int handle_builtin(char **args, const char *full_line) {
         }
     } else if (strcmp(args[0], "type") == 0) {
         my_type(args);
+    } else if (strcmp(args[0], "index") == 0) {
+        builtin_status = my_index(args);
+    } else if (strcmp(args[0], "du") == 0) {
+        builtin_status = my_du(args);
+    } else if (strcmp(args[0], "find") == 0) {
+        builtin_status = my_find(args);
+    } else if (strcmp(args[0], "hash") == 0) {
+        builtin_status = my_hash(args);
     }
     else return 0;
     return 1;
@@ -18,15 +18,23 @@ typedef struct {
 
 extern Alias aliases[MAX_ALIASES];
 extern int alias_count;
+extern int builtin_status;   // 最近一次内置命令的退出状态
 
 int is_builtin(const char *cmd);
-int run_builtin(char **args, const char *raw_line);
-int handle_builtin(char **args, const char *full_line);
-void my_cd(char **args);
+// 按给定的重定向执行内置命令，执行完恢复标准输入输出
+int run_builtin(char **args, const char *input_file, const char *output_file);
+int handle_builtin(char **args);
+int my_cd(char **args);
 void my_echo(char **args);
-void my_ls(char **args);
-void my_cat(char **args);
-void my_grep(char **args);
+int my_ls(char **args);
+// ls -l 的一行：权限、链接数、属主、属组、大小、名字
+void print_long_format(FILE *out, const struct stat *st, const char *name);
+int my_du(char **args);
+int my_find(char **args);
+int my_hash(char **args);
+int my_cat(char **args);
+int my_grep(char **args);
+int my_index(char **args);
 void add_history(const char *cmd);
 void show_history();
 void clear_history();
@@ -36,27 +44,53 @@ char *get_history_file_path();
 void show_prompt();
 
 //grep功能
-void process_file_or_dir(const char *path, const char *pattern, regex_t *regex,
-                        int ignore_case, int invert_match, int line_number,
-                        int count_only, int recursive, int files_with_matches,
-                        int only_matching, int extended_regex,
-                        int after_context, int before_context, int context_lines);
+typedef struct {
+    const char *pattern;
+    regex_t *regex;
+    int reg_flags;
+    struct Dfa *dfa;      // 内置 lazy DFA 引擎，非 NULL 时代替 regexec
+    int literal;          // 模式不含元字符时走子串搜索，不调用 regexec
+    const char *required; // 每个匹配都必须包含的字面串，用于预筛选（可为 NULL）
+    size_t required_len;
+    struct AhoCorasick *ac; // -e/-f 给出的一组固定字符串，非 NULL 时不用 regex
+    int ignore_case;
+    int invert_match;
+    int line_number;
+    int count_only;
+    int recursive;
+    int files_with_matches;
+    int only_matching;
+    int extended_regex;
+    int skip_binary;      // -I：跳过二进制文件
+    int quiet;            // -q：只返回状态
+    long max_count;       // -m：每个文件最多选中的行数，0 为不限
+    int after_context;
+    int before_context;
+    int context_lines;
+    char **include;       // --include：-r 时只搜索文件名匹配这些通配符的文件
+    int include_count;
+    char **exclude;       // --exclude：-r 时跳过文件名匹配的文件
+    int exclude_count;
+    int no_ignore;        // --no-ignore：-r 时不读 .gitignore/.ignore，也不跳过 .git
+    struct IgnoreSet *ignore;   // -r 遍历中各目录的忽略规则
+    int *quit;            // -q 命中后置位，让其余文件和线程提前结束
+    char **index_literals;      // 查三元组索引用的字面串（每个模式一个，可为 NULL）
+    int index_literal_count;
+    struct TrigramIndex *index; // -r 根目录下的索引，已按 index_literals 限定候选
+    size_t index_root_len;
 
-void process_directory(const char *dirpath, const char *pattern, regex_t *regex,
-                      int ignore_case, int invert_match, int line_number,
-                      int count_only, int files_with_matches,
-                      int only_matching, int extended_regex,
-                      int after_context, int before_context, int context_lines);
+    // 运行结果（多线程时每个线程累加到自己的副本，最后汇总）
+    long selected;
+    int had_error;
+} GrepOptions;
 
-void process_file(const char *filename, const char *pattern, regex_t *regex,
-                 int ignore_case, int invert_match, int line_number,
-                 int count_only, int files_with_matches,
-                 int only_matching, int extended_regex,
-                 int after_context, int before_context, int context_lines);
+void process_file_or_dir(const char *path, GrepOptions *opts);
+void process_directory(const char *dirpath, GrepOptions *opts);
+void process_file(const char *filename, GrepOptions *opts, FILE *out);
+void process_stdin(GrepOptions *opts, FILE *out);
+void print_line(FILE *out, const char *filename, long line_num, const char *line, size_t len,
+                int show_line_number, int only_matching, const regmatch_t *matches, int nmatch);
 
-void print_line(const char *filename, int line_num, const char *line, 
-               int show_line_number, int only_matching, const char *pattern);
-               
 // alias 功能
 void add_alias(const char *name, const char *command);
 void show_aliases();
@@ -66,7 +100,4 @@ void save_aliases_to_file();
 void load_aliases_from_file();
 void reset_aliases();
 
-void parse_redirection(char **args, char **input_file, char **output_file);
-void compress_args(char **args);
-
 #endif
@@ -0,0 +1,244 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+#include "builtin.h"
+
+#define CAT_CHUNK (1 << 30)          // 一次交给内核搬运的上限
+#define CAT_BUF_SIZE (256 * 1024)    // read/write 用的缓冲区
+#define CAT_BUF_ALIGN 4096
+
+enum { CAT_COPY_RANGE, CAT_SPLICE, CAT_SENDFILE };
+
+static ssize_t move_chunk(int method, int in_fd, int out_fd) {
+    switch (method) {
+    case CAT_COPY_RANGE:
+        return copy_file_range(in_fd, NULL, out_fd, NULL, CAT_CHUNK, 0);
+    case CAT_SPLICE:
+        return splice(in_fd, NULL, out_fd, NULL, CAT_CHUNK, SPLICE_F_MOVE | SPLICE_F_MORE);
+    default:
+        return sendfile(out_fd, in_fd, NULL, CAT_CHUNK);
+    }
+}
+
+// 数据在内核里直接从 in_fd 搬到 out_fd，不经过用户态缓冲区。
+// 返回 1 表示已搬完，0 表示这种方式不适用，交给下一种方式从当前位置接着搬，-1 为出错
+static int kernel_copy(int method, int in_fd, int out_fd) {
+    int moved = 0;
+    while (1) {
+        ssize_t n = move_chunk(method, in_fd, out_fd);
+        if (n > 0) {
+            moved = 1;
+            continue;
+        }
+        // 一个字节都没搬到就结束的，交给 read 再确认一次（/proc 下的文件大小为 0 却有内容）
+        if (n == 0) return moved;
+        if (errno == EINTR) continue;
+        if (errno == EINVAL || errno == ENOSYS || errno == EXDEV ||
+            errno == EOPNOTSUPP || errno == EBADF) {
+            return 0;
+        }
+        return -1;
+    }
+}
+
+static int copy_with_buffer(int in_fd, int out_fd) {
+    void *buf;
+    if (posix_memalign(&buf, CAT_BUF_ALIGN, CAT_BUF_SIZE) != 0) return -1;
+    int result = 0;
+    while (1) {
+        ssize_t n = read(in_fd, buf, CAT_BUF_SIZE);
+        if (n == 0) break;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            result = -1;
+            break;
+        }
+        for (ssize_t done = 0; done < n; ) {
+            ssize_t w = write(out_fd, (char *)buf + done, n - done);
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                result = -1;
+                break;
+            }
+            done += w;
+        }
+        if (result < 0) break;
+    }
+    free(buf);
+    return result;
+}
+
+// cat -n 的输出缓冲：攒满一块再整体 write
+typedef struct {
+    int fd;
+    char *buf;
+    size_t len;
+    int failed;
+} CatOut;
+
+static void out_flush(CatOut *o) {
+    for (size_t done = 0; done < o->len && !o->failed; ) {
+        ssize_t w = write(o->fd, o->buf + done, o->len - done);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            o->failed = 1;
+            break;
+        }
+        done += w;
+    }
+    o->len = 0;
+}
+
+static void out_append(CatOut *o, const char *data, size_t n) {
+    if (o->len + n > CAT_BUF_SIZE) {
+        out_flush(o);
+        if (n > CAT_BUF_SIZE) {
+            // 超长的行段不进缓冲区，直接写出
+            CatOut direct = {o->fd, (char *)data, n, 0};
+            out_flush(&direct);
+            o->failed |= direct.failed;
+            return;
+        }
+    }
+    memcpy(o->buf + o->len, data, n);
+    o->len += n;
+}
+
+// 行号前缀按 "%6d  " 的格式保存，逐行在原地加一，不必每行都 printf
+typedef struct {
+    char text[32];
+    int len;
+} LineNumber;
+
+static void line_number_next(LineNumber *num) {
+    for (int i = num->len - 3; i >= 0; i--) {
+        if (num->text[i] == ' ') {
+            num->text[i] = '1';
+            return;
+        }
+        if (num->text[i] < '9') {
+            num->text[i]++;
+            return;
+        }
+        num->text[i] = '0';
+    }
+    // 全是 9 且没有留白，位数加一
+    memmove(num->text + 1, num->text, num->len);
+    num->text[0] = '1';
+    num->len++;
+}
+
+// 整块读入，用 memchr 找换行（glibc 的实现是向量化的），行号和内容一起拼进输出缓冲区，
+// 行多长都只编一个号
+static int cat_number_fd(int in_fd, const char *name) {
+    fflush(stdout);
+    char *in = NULL, *buf = NULL;
+    if (posix_memalign((void **)&in, CAT_BUF_ALIGN, CAT_BUF_SIZE) != 0 ||
+        posix_memalign((void **)&buf, CAT_BUF_ALIGN, CAT_BUF_SIZE) != 0) {
+        perror(name);
+        free(in);
+        return 1;
+    }
+    CatOut out = {STDOUT_FILENO, buf, 0, 0};
+    LineNumber num;
+    num.len = snprintf(num.text, sizeof(num.text), "%6d  ", 1);
+    int at_line_start = 1;
+    int read_failed = 0;
+
+    while (!out.failed) {
+        ssize_t n = read(in_fd, in, CAT_BUF_SIZE);
+        if (n == 0) break;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            read_failed = 1;
+            break;
+        }
+        const char *p = in, *end = in + n;
+        while (p < end) {
+            if (at_line_start) {
+                out_append(&out, num.text, num.len);
+                line_number_next(&num);
+                at_line_start = 0;
+            }
+            const char *nl = memchr(p, '\n', end - p);
+            const char *seg_end = nl ? nl + 1 : end;
+            out_append(&out, p, seg_end - p);
+            at_line_start = nl != NULL;
+            p = seg_end;
+        }
+    }
+    if (read_failed) perror(name);
+    out_flush(&out);
+    if (out.failed) perror("cat: write");
+    free(in);
+    free(buf);
+    return read_failed || out.failed;
+}
+
+// 按两端的类型挑搬运方式：文件到文件用 copy_file_range，一端是管道用 splice，
+// 从文件到其它（终端、套接字、跨文件系统的文件）用 sendfile，都不行再用大块 read/write
+static int cat_fd(int in_fd, const char *name) {
+    int out_fd = STDOUT_FILENO;
+    fflush(stdout);
+
+    struct stat in_st, out_st;
+    int in_file = 0, in_pipe = 0, out_file = 0, out_pipe = 0;
+    if (fstat(in_fd, &in_st) == 0) {
+        in_file = S_ISREG(in_st.st_mode) && in_st.st_size > 0;
+        in_pipe = S_ISFIFO(in_st.st_mode);
+    }
+    if (fstat(out_fd, &out_st) == 0) {
+        out_file = S_ISREG(out_st.st_mode);
+        out_pipe = S_ISFIFO(out_st.st_mode);
+    }
+
+    int r = 0;
+    if (in_file && out_file) r = kernel_copy(CAT_COPY_RANGE, in_fd, out_fd);
+    if (r == 0 && (in_pipe || out_pipe)) r = kernel_copy(CAT_SPLICE, in_fd, out_fd);
+    if (r == 0 && in_file) r = kernel_copy(CAT_SENDFILE, in_fd, out_fd);
+    if (r == 0) r = copy_with_buffer(in_fd, out_fd);
+    if (r < 0) perror(name);
+    return r < 0;
+}
+
+int my_cat(char **args) {
+    int show_line_numbers = 0;
+    int start_index = 1;
+
+    if (args[1] && strcmp(args[1], "-n") == 0) {
+        show_line_numbers = 1;
+        start_index = 2;
+    }
+
+    //  若无参数（如 cat 或 cat < file），从标准输入读取
+    if (!args[start_index]) {
+        if (show_line_numbers) {
+            return cat_number_fd(STDIN_FILENO, "stdin");
+        }
+        return cat_fd(STDIN_FILENO, "stdin");
+    }
+
+    // 否则逐个读取文件，行号每个文件从 1 开始
+    int status = 0;
+    for (int i = start_index; args[i]; i++) {
+        int fd = open(args[i], O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            perror(args[i]);
+            status = 1;
+            continue;
+        }
+        if (show_line_numbers) {
+            status |= cat_number_fd(fd, args[i]);
+        } else {
+            status |= cat_fd(fd, args[i]);
+        }
+        close(fd);
+    }
+    return status;
+}
@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include "cmdhash.h"
+#include "builtin.h"
+
+#define CMD_BUCKETS 64
+
+typedef struct CmdEntry {
+    char *name;
+    char *path;
+    int hits;
+    struct CmdEntry *next;
+} CmdEntry;
+
+static CmdEntry *buckets[CMD_BUCKETS];
+static char *hashed_path;   // 建表时的 PATH，与当前不同时整表作废
+
+static unsigned name_hash(const char *s) {
+    unsigned h = 5381;
+    while (*s) h = h * 33 + (unsigned char)*s++;
+    return h % CMD_BUCKETS;
+}
+
+void cmd_hash_clear(void) {
+    for (int i = 0; i < CMD_BUCKETS; i++) {
+        CmdEntry *e = buckets[i];
+        while (e) {
+            CmdEntry *next = e->next;
+            free(e->name);
+            free(e->path);
+            free(e);
+            e = next;
+        }
+        buckets[i] = NULL;
+    }
+    free(hashed_path);
+    hashed_path = NULL;
+}
+
+static void check_path_changed(void) {
+    const char *path = getenv("PATH");
+    if (!hashed_path && !path) return;
+    if (hashed_path && path && strcmp(hashed_path, path) == 0) return;
+    cmd_hash_clear();
+    if (path) hashed_path = strdup(path);
+}
+
+// 按 PATH 顺序查找；*cacheable 表示找到的目录是绝对路径，cd 之后结果仍然有效
+static char *search_path(const char *cmd, int *cacheable) {
+    const char *path = getenv("PATH");
+    if (!path) return NULL;
+    char full[PATH_MAX];
+    size_t cmd_len = strlen(cmd);
+    for (const char *dir = path; ; ) {
+        const char *end = strchr(dir, ':');
+        size_t len = end ? (size_t)(end - dir) : strlen(dir);
+        // 空的一段表示当前目录
+        if (len + 1 + cmd_len < sizeof(full)) {
+            if (len == 0) {
+                snprintf(full, sizeof(full), "./%s", cmd);
+            } else {
+                snprintf(full, sizeof(full), "%.*s/%s", (int)len, dir, cmd);
+            }
+            if (access(full, X_OK) == 0) {
+                *cacheable = len > 0 && dir[0] == '/';
+                return strdup(full);
+            }
+        }
+        if (!end) break;
+        dir = end + 1;
+    }
+    return NULL;
+}
+
+char *cmd_hash_lookup(const char *cmd, int exec) {
+    if (strchr(cmd, '/')) {
+        return access(cmd, X_OK) == 0 ? strdup(cmd) : NULL;
+    }
+    check_path_changed();
+    unsigned h = name_hash(cmd);
+    for (CmdEntry *e = buckets[h]; e; e = e->next) {
+        if (strcmp(e->name, cmd) == 0) {
+            if (exec) e->hits++;
+            return strdup(e->path);
+        }
+    }
+
+    int cacheable = 0;
+    char *found = search_path(cmd, &cacheable);
+    if (found && cacheable) {
+        CmdEntry *e = malloc(sizeof(CmdEntry));
+        if (e) {
+            e->name = strdup(cmd);
+            e->path = strdup(found);
+            e->hits = exec ? 1 : 0;
+            e->next = buckets[h];
+            buckets[h] = e;
+        }
+    }
+    return found;
+}
+
+void cmd_hash_forget(const char *cmd) {
+    for (CmdEntry **p = &buckets[name_hash(cmd)]; *p; p = &(*p)->next) {
+        if (strcmp((*p)->name, cmd) == 0) {
+            CmdEntry *e = *p;
+            *p = e->next;
+            free(e->name);
+            free(e->path);
+            free(e);
+            return;
+        }
+    }
+}
+
+void cmd_hash_print(FILE *out) {
+    check_path_changed();
+    int any = 0;
+    for (int i = 0; i < CMD_BUCKETS; i++) {
+        for (CmdEntry *e = buckets[i]; e; e = e->next) {
+            if (!any) fprintf(out, "hits\tcommand\n");
+            any = 1;
+            fprintf(out, "%4d\t%s\n", e->hits, e->path);
+        }
+    }
+    if (!any) fprintf(out, "hash: hash table empty\n");
+}
+
+// hash：列出缓存；hash -r：清空；hash 命令名...：查找并记下
+int my_hash(char **args) {
+    if (!args[1]) {
+        cmd_hash_print(stdout);
+        return 0;
+    }
+    int status = 0;
+    for (int i = 1; args[i]; i++) {
+        if (strcmp(args[i], "-r") == 0) {
+            cmd_hash_clear();
+            continue;
+        }
+        char *path = cmd_hash_lookup(args[i], 0);
+        if (!path) {
+            fprintf(stderr, "hash: %s: not found\n", args[i]);
+            status = 1;
+        }
+        free(path);
+    }
+    return status;
+}
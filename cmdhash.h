@@ -0,0 +1,16 @@
+#ifndef CMDHASH_H
+#define CMDHASH_H
+
+#include <stdio.h>
+
+// 命令名到绝对路径的缓存（同 bash 的 hash）：第一次用到时按 PATH 查找，之后直接用记下的路径，
+// 不再每次把 PATH 里的目录挨个 access 一遍。PATH 变了整表作废，exec 报 ENOENT 时删掉该条。
+// 名字里带 '/' 的、在相对路径目录里找到的命令不缓存
+
+// 返回命令的完整路径（调用者 free），找不到返回 NULL；exec 非 0 时计入命中次数
+char *cmd_hash_lookup(const char *cmd, int exec);
+void cmd_hash_forget(const char *cmd);
+void cmd_hash_clear(void);
+void cmd_hash_print(FILE *out);
+
+#endif
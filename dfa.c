@@ -0,0 +1,865 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "dfa.h"
+
+#define DFA_MAX_INSTS  100000   // NFA 指令数上限，超过就交给 regexec
+#define DFA_MAX_REPEAT 255      // {m,n} 要展开成副本，次数太大时不支持
+#define DFA_MAX_DEPTH  200      // 括号嵌套深度上限
+#define DFA_MAX_STATES 4096     // 缓存的 DFA 状态数上限，满了整体清空重建
+#define DFA_TABLE_SIZE (DFA_MAX_STATES * 2)
+
+// 语法树
+enum { N_EMPTY, N_SET, N_BOL, N_EOL, N_CAT, N_ALT, N_REPEAT };
+
+typedef struct Node {
+    int type;
+    int set;                  // N_SET：字符集编号
+    int min, max;             // N_REPEAT：max 为 -1 表示不限次数
+    struct Node *left, *right;
+} Node;
+
+// NFA 指令
+enum { I_CHAR, I_SPLIT, I_JMP, I_BOL, I_EOL, I_MATCH };
+
+typedef struct {
+    int op;
+    int x, y;                 // I_CHAR：x 为字符集；I_SPLIT / I_JMP：跳转目标
+} Inst;
+
+typedef struct {
+    unsigned char bits[32];
+} CharSet;
+
+// 一个 DFA 状态就是一组 NFA 状态（只留 I_CHAR / I_EOL / I_MATCH，已排序）
+typedef struct {
+    int *pcs;
+    int npcs;
+    int at_bol;               // 行首的起始状态，只对空行的 $ 判断有影响
+    int anchored;             // 锚定状态：不含起点闭包，只跟踪从某个固定起点开始的匹配
+    int accept;               // 已经包含 I_MATCH
+    int accept_eol;           // 行在此结束时能匹配（$ 成立）
+    unsigned hash;
+} DState;
+
+struct Dfa {
+    Inst *prog;
+    int nprog;
+    CharSet *sets;
+    int nsets;
+    int nclass;
+    unsigned char byte_class[256];
+    unsigned char class_rep[256];   // 每个字节类挑一个字节作代表
+
+    DState *states;
+    int nstates, cap;
+    int *trans;                     // trans[状态 * nclass + 字节类]，-1 表示还没算过
+    unsigned char *stop;            // 1：已匹配；2：死状态；扫描到这里就可以停
+    int table[DFA_TABLE_SIZE];      // 状态哈希表，存编号 + 1
+    int start[2][2];                // 起始状态编号 [anchored][at_bol]，-1 表示需要重建
+
+    // 未锚定搜索时每个位置都可以开始新的匹配，相当于模式前面有一个 .*。
+    // 这部分 NFA 状态（起点闭包）每个 DFA 状态都含有，所以不存进状态里，
+    // 它读入各字节类后的闭包也只算一次；大量 '|' 时状态集合因此仍然很小
+    unsigned char *in_start;        // pc 是否属于起点闭包
+    int *start_pcs;
+    int nstart;
+    int start_accept;               // 起点闭包含 I_MATCH（模式能匹配空串）
+    int **class_next;               // 起点闭包读入各字节类后的闭包，NULL 表示还没算
+    int *class_nnext;
+
+    // dfa_find 找起点用的反向自动机：模式倒过来编译，第一次 dfa_find 时才建
+    char *pattern;
+    int ignore_case;
+    struct Dfa *reverse;
+
+    // 求闭包用的工作区
+    int *stack;
+    int *seeds;
+    int *buf;
+    unsigned *mark;
+    unsigned gen;
+};
+
+typedef struct {
+    const char *p;
+    size_t pos, n;
+    int ignore_case;
+    int bad;                  // 有不支持的写法（或语法错误）
+    int depth;
+    Dfa *dfa;
+    Node **nodes;             // 所有分配过的节点，编译完统一释放
+    int nnodes, cap;
+    int overflow;             // NFA 超出上限
+    int reversed;             // 编成反向 NFA：连接倒序，^ 与 $ 互换
+} Parser;
+
+static Node *node_new(Parser *ps, int type, Node *left, Node *right) {
+    if (ps->nnodes == ps->cap) {
+        ps->cap = ps->cap ? ps->cap * 2 : 64;
+        Node **nodes = realloc(ps->nodes, ps->cap * sizeof(Node *));
+        if (!nodes) {
+            ps->bad = 1;
+            return NULL;
+        }
+        ps->nodes = nodes;
+    }
+    Node *n = calloc(1, sizeof(Node));
+    if (!n) {
+        ps->bad = 1;
+        return NULL;
+    }
+    n->type = type;
+    n->left = left;
+    n->right = right;
+    ps->nodes[ps->nnodes++] = n;
+    return n;
+}
+
+static void set_add(CharSet *set, int c) {
+    set->bits[c >> 3] |= 1 << (c & 7);
+}
+
+static int set_has(const CharSet *set, int c) {
+    return set->bits[c >> 3] & (1 << (c & 7));
+}
+
+// 新建一个字符集节点，-i 时把大小写补全
+static Node *set_node(Parser *ps, CharSet *set) {
+    if (ps->ignore_case) {
+        for (int c = 0; c < 256; c++) {
+            if (set_has(set, c)) {
+                set_add(set, tolower(c));
+                set_add(set, toupper(c));
+            }
+        }
+    }
+    Dfa *d = ps->dfa;
+    if ((d->nsets & (d->nsets - 1)) == 0) {
+        CharSet *sets = realloc(d->sets, (d->nsets ? d->nsets * 2 : 1) * sizeof(CharSet));
+        if (!sets) {
+            ps->bad = 1;
+            return NULL;
+        }
+        d->sets = sets;
+    }
+    d->sets[d->nsets] = *set;
+    Node *n = node_new(ps, N_SET, NULL, NULL);
+    if (n) n->set = d->nsets++;
+    return n;
+}
+
+static Node *literal_node(Parser *ps, int c) {
+    CharSet set = {{0}};
+    set_add(&set, c);
+    return set_node(ps, &set);
+}
+
+static int (*class_func(const char *name, size_t len))(int) {
+    static const struct {
+        const char *name;
+        int (*fn)(int);
+    } classes[] = {
+        {"alpha", isalpha}, {"digit", isdigit}, {"alnum", isalnum}, {"upper", isupper},
+        {"lower", islower}, {"space", isspace}, {"blank", isblank}, {"punct", ispunct},
+        {"print", isprint}, {"graph", isgraph}, {"cntrl", iscntrl}, {"xdigit", isxdigit},
+    };
+    for (size_t i = 0; i < sizeof(classes) / sizeof(classes[0]); i++) {
+        if (strlen(classes[i].name) == len && strncmp(classes[i].name, name, len) == 0) {
+            return classes[i].fn;
+        }
+    }
+    return NULL;
+}
+
+// 方括号表达式，ps->pos 指向 '['
+static Node *parse_bracket(Parser *ps) {
+    const char *p = ps->p;
+    size_t i = ps->pos + 1, n = ps->n;
+    CharSet set = {{0}};
+    int negate = 0;
+    if (i < n && p[i] == '^') {
+        negate = 1;
+        i++;
+    }
+    for (int first = 1; ; first = 0) {
+        if (i >= n) {
+            ps->bad = 1;
+            return NULL;
+        }
+        int c = (unsigned char)p[i];
+        if (c == ']' && !first) {
+            i++;
+            break;
+        }
+        if (c == '[' && i + 1 < n && (p[i + 1] == '.' || p[i + 1] == '=')) {
+            ps->bad = 1;     // 排序元素和等价类不支持
+            return NULL;
+        }
+        if (c == '[' && i + 1 < n && p[i + 1] == ':') {
+            const char *name = p + i + 2;
+            const char *close = strstr(name, ":]");
+            int (*fn)(int) = close ? class_func(name, close - name) : NULL;
+            if (!fn) {
+                ps->bad = 1;
+                return NULL;
+            }
+            for (int b = 0; b < 256; b++) {
+                if (fn(b)) set_add(&set, b);
+            }
+            i = close - p + 2;
+            continue;
+        }
+        i++;
+        int hi = c;
+        if (i + 1 < n && p[i] == '-' && p[i + 1] != ']') {
+            hi = (unsigned char)p[i + 1];
+            if (hi == '[' || hi < c) {
+                ps->bad = 1;
+                return NULL;
+            }
+            i += 2;
+        }
+        for (int b = c; b <= hi; b++) {
+            set_add(&set, b);
+        }
+    }
+    ps->pos = i;
+
+    if (negate) {
+        // 先按 -i 补全再取反，[^a] 在 -i 下也不匹配 'A'
+        if (ps->ignore_case) {
+            for (int b = 0; b < 256; b++) {
+                if (set_has(&set, b)) {
+                    set_add(&set, tolower(b));
+                    set_add(&set, toupper(b));
+                }
+            }
+        }
+        for (int b = 0; b < 32; b++) {
+            set.bits[b] = ~set.bits[b];
+        }
+    }
+    return set_node(ps, &set);
+}
+
+static Node *parse_alt(Parser *ps);
+
+static Node *parse_atom(Parser *ps) {
+    int c = (unsigned char)ps->p[ps->pos];
+    if (c == '[') return parse_bracket(ps);
+    ps->pos++;
+    switch (c) {
+    case '(': {
+        if (++ps->depth > DFA_MAX_DEPTH) {
+            ps->bad = 1;
+            return NULL;
+        }
+        Node *n = parse_alt(ps);
+        if (ps->bad || ps->pos >= ps->n || ps->p[ps->pos] != ')') {
+            ps->bad = 1;
+            return NULL;
+        }
+        ps->pos++;
+        ps->depth--;
+        return n;
+    }
+    case '.': {
+        // 与 glibc 的 POSIX ERE 一致：'.' 不匹配 NUL
+        CharSet set;
+        memset(&set, 0xff, sizeof(set));
+        set.bits[0] &= ~1;
+        return set_node(ps, &set);
+    }
+    case '^':
+        return node_new(ps, N_BOL, NULL, NULL);
+    case '$':
+        return node_new(ps, N_EOL, NULL, NULL);
+    case '*':
+    case '+':
+    case '?':
+    case '{':
+        ps->bad = 1;
+        return NULL;
+    case '\\': {
+        // 只接受转义的标点；\1、\w、\b 等交给 regexec。
+        // \< \> \` \' 在 glibc 里是词首、词尾、缓冲区首尾的锚点，不是字面的标点，同样交给 regexec
+        if (ps->pos >= ps->n) {
+            ps->bad = 1;
+            return NULL;
+        }
+        int e = (unsigned char)ps->p[ps->pos++];
+        if (!ispunct(e) || strchr("<>`'", e)) {
+            ps->bad = 1;
+            return NULL;
+        }
+        return literal_node(ps, e);
+    }
+    default:
+        return literal_node(ps, c);
+    }
+}
+
+// {m}、{m,}、{m,n}，以及 glibc 接受的 {,n}（下限为 0）；ps->pos 指向 '{'
+static int parse_interval(Parser *ps, int *min, int *max) {
+    const char *p = ps->p;
+    size_t i = ps->pos + 1;
+    long lo = 0;
+    if (i < ps->n && isdigit((unsigned char)p[i])) {
+        lo = strtol(p + i, NULL, 10);
+        while (i < ps->n && isdigit((unsigned char)p[i])) i++;
+    } else if (i >= ps->n || p[i] != ',') {
+        return -1;
+    }
+    long hi = lo;
+    if (i < ps->n && p[i] == ',') {
+        i++;
+        hi = -1;
+        if (i < ps->n && isdigit((unsigned char)p[i])) {
+            hi = strtol(p + i, NULL, 10);
+            while (i < ps->n && isdigit((unsigned char)p[i])) i++;
+        }
+    }
+    if (i >= ps->n || p[i] != '}') return -1;
+    if (lo > DFA_MAX_REPEAT || hi > DFA_MAX_REPEAT || (hi >= 0 && hi < lo)) return -1;
+    ps->pos = i + 1;
+    *min = (int)lo;
+    *max = (int)hi;
+    return 0;
+}
+
+static Node *parse_repeat(Parser *ps) {
+    Node *atom = parse_atom(ps);
+    while (!ps->bad && ps->pos < ps->n) {
+        int c = ps->p[ps->pos];
+        int min, max;
+        if (c == '*') {
+            min = 0;
+            max = -1;
+            ps->pos++;
+        } else if (c == '+') {
+            min = 1;
+            max = -1;
+            ps->pos++;
+        } else if (c == '?') {
+            min = 0;
+            max = 1;
+            ps->pos++;
+        } else if (c == '{') {
+            if (parse_interval(ps, &min, &max) != 0) {
+                ps->bad = 1;
+                return NULL;
+            }
+        } else {
+            break;
+        }
+        if (atom->type == N_BOL || atom->type == N_EOL) {
+            ps->bad = 1;
+            return NULL;
+        }
+        atom = node_new(ps, N_REPEAT, atom, NULL);
+        if (!atom) return NULL;
+        atom->min = min;
+        atom->max = max;
+    }
+    return ps->bad ? NULL : atom;
+}
+
+static Node *parse_cat(Parser *ps) {
+    Node *result = NULL;
+    while (!ps->bad && ps->pos < ps->n && ps->p[ps->pos] != '|' && ps->p[ps->pos] != ')') {
+        Node *atom = parse_repeat(ps);
+        if (!atom) return NULL;
+        result = result ? node_new(ps, N_CAT, result, atom) : atom;
+    }
+    if (ps->bad) return NULL;
+    return result ? result : node_new(ps, N_EMPTY, NULL, NULL);
+}
+
+static Node *parse_alt(Parser *ps) {
+    Node *left = parse_cat(ps);
+    while (!ps->bad && ps->pos < ps->n && ps->p[ps->pos] == '|') {
+        ps->pos++;
+        Node *right = parse_cat(ps);
+        if (!right) return NULL;
+        left = node_new(ps, N_ALT, left, right);
+    }
+    return ps->bad ? NULL : left;
+}
+
+static int emit(Parser *ps, int op) {
+    Dfa *d = ps->dfa;
+    if (d->nprog >= DFA_MAX_INSTS) {
+        ps->overflow = 1;
+        return 0;
+    }
+    if ((d->nprog & (d->nprog - 1)) == 0) {
+        Inst *prog = realloc(d->prog, (d->nprog ? d->nprog * 2 : 1) * sizeof(Inst));
+        if (!prog) {
+            ps->overflow = 1;
+            return 0;
+        }
+        d->prog = prog;
+    }
+    d->prog[d->nprog].op = op;
+    d->prog[d->nprog].x = d->prog[d->nprog].y = 0;
+    return d->nprog++;
+}
+
+// 语法树编成 Thompson NFA；{m,n} 展开成 m 个必选副本加 n-m 个可选副本
+static void compile_node(Parser *ps, Node *n) {
+    Dfa *d = ps->dfa;
+    if (ps->overflow) return;
+    switch (n->type) {
+    case N_EMPTY:
+        break;
+    case N_SET: {
+        int pc = emit(ps, I_CHAR);
+        d->prog[pc].x = n->set;
+        break;
+    }
+    case N_BOL:
+        emit(ps, ps->reversed ? I_EOL : I_BOL);
+        break;
+    case N_EOL:
+        emit(ps, ps->reversed ? I_BOL : I_EOL);
+        break;
+    case N_CAT:
+        compile_node(ps, ps->reversed ? n->right : n->left);
+        compile_node(ps, ps->reversed ? n->left : n->right);
+        break;
+    case N_ALT: {
+        int split = emit(ps, I_SPLIT);
+        d->prog[split].x = split + 1;
+        compile_node(ps, n->left);
+        int jmp = emit(ps, I_JMP);
+        d->prog[split].y = d->nprog;
+        compile_node(ps, n->right);
+        d->prog[jmp].x = d->nprog;
+        break;
+    }
+    case N_REPEAT: {
+        int copies = n->max < 0 && n->min > 0 ? n->min - 1 : n->min;
+        for (int i = 0; i < copies; i++) {
+            compile_node(ps, n->left);
+        }
+        if (n->max < 0 && n->min > 0) {
+            // x+：先走一遍，再决定是否回头
+            int loop = d->nprog;
+            compile_node(ps, n->left);
+            int split = emit(ps, I_SPLIT);
+            d->prog[split].x = loop;
+            d->prog[split].y = split + 1;
+        } else if (n->max < 0) {
+            int split = emit(ps, I_SPLIT);
+            d->prog[split].x = split + 1;
+            compile_node(ps, n->left);
+            int jmp = emit(ps, I_JMP);
+            d->prog[jmp].x = split;
+            d->prog[split].y = d->nprog;
+        } else {
+            int optional = n->max - n->min;
+            int *splits = malloc((optional + 1) * sizeof(int));
+            if (!splits) {
+                ps->overflow = 1;
+                return;
+            }
+            for (int i = 0; i < optional; i++) {
+                splits[i] = emit(ps, I_SPLIT);
+                d->prog[splits[i]].x = splits[i] + 1;
+                compile_node(ps, n->left);
+            }
+            for (int i = 0; i < optional; i++) {
+                d->prog[splits[i]].y = d->nprog;
+            }
+            free(splits);
+        }
+        break;
+    }
+    }
+}
+
+// 所有字符集共同划分出的字节类：同一类的字节在任何字符集里要么都在、要么都不在
+static void build_byte_classes(Dfa *d) {
+    int nclass = 1;
+    memset(d->byte_class, 0, sizeof(d->byte_class));
+    for (int s = 0; s < d->nsets; s++) {
+        short remap[512];
+        memset(remap, -1, sizeof(remap));
+        int count = 0;
+        for (int b = 0; b < 256; b++) {
+            int key = d->byte_class[b] * 2 + (set_has(&d->sets[s], b) ? 1 : 0);
+            if (remap[key] < 0) remap[key] = count++;
+            d->byte_class[b] = remap[key];
+        }
+        nclass = count;
+    }
+    d->nclass = nclass;
+    for (int b = 255; b >= 0; b--) {
+        d->class_rep[d->byte_class[b]] = b;
+    }
+}
+
+static int init_start(Dfa *d);
+
+static Dfa *compile(const char *pattern, int ignore_case, int reversed) {
+    Dfa *d = calloc(1, sizeof(Dfa));
+    if (!d) return NULL;
+    memset(d->start, -1, sizeof(d->start));
+
+    Parser ps = {0};
+    ps.p = pattern;
+    ps.n = strlen(pattern);
+    ps.ignore_case = ignore_case;
+    ps.dfa = d;
+    ps.reversed = reversed;
+    Node *root = parse_alt(&ps);
+    if (root && ps.pos == ps.n) {    // 剩下的只可能是多余的 ')'
+        compile_node(&ps, root);
+        emit(&ps, I_MATCH);
+    } else {
+        ps.bad = 1;
+    }
+    for (int i = 0; i < ps.nnodes; i++) {
+        free(ps.nodes[i]);
+    }
+    free(ps.nodes);
+    if (ps.bad || ps.overflow) {
+        dfa_free(d);
+        return NULL;
+    }
+
+    build_byte_classes(d);
+    d->stack = malloc(d->nprog * sizeof(int));
+    d->seeds = malloc(d->nprog * sizeof(int));
+    d->buf = malloc(d->nprog * sizeof(int));
+    d->mark = calloc(d->nprog, sizeof(unsigned));
+    d->in_start = calloc(d->nprog, 1);
+    d->states = malloc(DFA_MAX_STATES * sizeof(DState));
+    d->class_next = calloc(d->nclass, sizeof(int *));
+    d->class_nnext = calloc(d->nclass, sizeof(int));
+    if (!d->stack || !d->seeds || !d->buf || !d->mark || !d->in_start || !d->states ||
+        !d->class_next || !d->class_nnext || init_start(d) != 0) {
+        dfa_free(d);
+        return NULL;
+    }
+    return d;
+}
+
+Dfa *dfa_compile(const char *pattern, int ignore_case) {
+    Dfa *d = compile(pattern, ignore_case, 0);
+    if (d && !(d->pattern = strdup(pattern))) {
+        dfa_free(d);
+        return NULL;
+    }
+    if (d) d->ignore_case = ignore_case;
+    return d;
+}
+
+static int compare_ints(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+// 从 seeds 沿空转移展开，结果（未排序）写入 d->buf，本轮访问过的 pc 在 d->mark 中
+static int closure(Dfa *d, const int *seeds, int nseeds, int at_bol, int at_eol) {
+    if (++d->gen == 0) {
+        memset(d->mark, 0, d->nprog * sizeof(unsigned));
+        d->gen = 1;
+    }
+    int sp = 0, n = 0;
+    for (int i = 0; i < nseeds; i++) {
+        if (d->mark[seeds[i]] != d->gen) {
+            d->mark[seeds[i]] = d->gen;
+            d->stack[sp++] = seeds[i];
+        }
+    }
+    while (sp > 0) {
+        int pc = d->stack[--sp];
+        const Inst *in = &d->prog[pc];
+        int next[2], nnext = 0;
+        switch (in->op) {
+        case I_JMP:
+            next[nnext++] = in->x;
+            break;
+        case I_SPLIT:
+            next[nnext++] = in->x;
+            next[nnext++] = in->y;
+            break;
+        case I_BOL:
+            if (at_bol) next[nnext++] = pc + 1;
+            break;
+        case I_EOL:
+            if (at_eol) next[nnext++] = pc + 1;
+            else d->buf[n++] = pc;
+            break;
+        default:
+            d->buf[n++] = pc;
+            break;
+        }
+        for (int i = 0; i < nnext; i++) {
+            if (d->mark[next[i]] != d->gen) {
+                d->mark[next[i]] = d->gen;
+                d->stack[sp++] = next[i];
+            }
+        }
+    }
+    return n;
+}
+
+// 在刚算完的闭包里并入 extra（本身已是闭包），未锚定时去掉起点闭包里的 pc，排序
+static int finish_set(Dfa *d, int n, const int *extra, int nextra, int anchored) {
+    for (int i = 0; i < nextra; i++) {
+        if (d->mark[extra[i]] != d->gen) {
+            d->mark[extra[i]] = d->gen;
+            d->buf[n++] = extra[i];
+        }
+    }
+    int m = 0;
+    for (int i = 0; i < n; i++) {
+        if (anchored || !d->in_start[d->buf[i]]) d->buf[m++] = d->buf[i];
+    }
+    qsort(d->buf, m, sizeof(int), compare_ints);
+    return m;
+}
+
+static int init_start(Dfa *d) {
+    int zero = 0;
+    int n = closure(d, &zero, 1, 0, 0);
+    d->start_pcs = malloc((n ? n : 1) * sizeof(int));
+    if (!d->start_pcs) return -1;
+    memcpy(d->start_pcs, d->buf, n * sizeof(int));
+    d->nstart = n;
+    for (int i = 0; i < n; i++) {
+        d->in_start[d->buf[i]] = 1;
+        if (d->prog[d->buf[i]].op == I_MATCH) d->start_accept = 1;
+    }
+    return 0;
+}
+
+// 起点闭包读入字节类 cls 后的闭包
+static int class_successors(Dfa *d, int cls) {
+    if (d->class_next[cls]) return 0;
+    int rep = d->class_rep[cls];
+    int nseeds = 0;
+    for (int i = 0; i < d->nstart; i++) {
+        const Inst *in = &d->prog[d->start_pcs[i]];
+        if (in->op == I_CHAR && set_has(&d->sets[in->x], rep)) {
+            d->seeds[nseeds++] = d->start_pcs[i] + 1;
+        }
+    }
+    int n = closure(d, d->seeds, nseeds, 0, 0);
+    int *list = malloc((n ? n : 1) * sizeof(int));
+    if (!list) return -1;
+    memcpy(list, d->buf, n * sizeof(int));
+    d->class_next[cls] = list;
+    d->class_nnext[cls] = n;
+    return 0;
+}
+
+static void flush_states(Dfa *d) {
+    for (int i = 0; i < d->nstates; i++) {
+        free(d->states[i].pcs);
+    }
+    d->nstates = 0;
+    memset(d->start, -1, sizeof(d->start));
+    memset(d->table, 0, sizeof(d->table));
+}
+
+// 查找或新建 d->buf[0..n) 对应的状态（未锚定时另含起点闭包）；缓存已满返回 -1
+static int intern_state(Dfa *d, int n, int at_bol, int anchored) {
+    unsigned hash = 2166136261u ^ (unsigned)(at_bol | anchored << 1);
+    for (int i = 0; i < n; i++) {
+        hash = (hash ^ (unsigned)d->buf[i]) * 16777619u;
+    }
+    unsigned slot = hash & (DFA_TABLE_SIZE - 1);
+    while (d->table[slot]) {
+        DState *st = &d->states[d->table[slot] - 1];
+        if (st->hash == hash && st->npcs == n && st->at_bol == at_bol && st->anchored == anchored &&
+            memcmp(st->pcs, d->buf, n * sizeof(int)) == 0) {
+            return d->table[slot] - 1;
+        }
+        slot = (slot + 1) & (DFA_TABLE_SIZE - 1);
+    }
+    if (d->nstates == DFA_MAX_STATES) return -1;
+    if (d->nstates == d->cap) {
+        int cap = d->cap ? d->cap * 2 : 16;
+        int *trans = realloc(d->trans, (size_t)cap * d->nclass * sizeof(int));
+        if (trans) d->trans = trans;
+        unsigned char *stop = realloc(d->stop, cap);
+        if (stop) d->stop = stop;
+        if (!trans || !stop) return -1;
+        d->cap = cap;
+    }
+
+    DState *st = &d->states[d->nstates];
+    st->pcs = malloc((n ? n : 1) * sizeof(int));
+    if (!st->pcs) return -1;
+    memcpy(st->pcs, d->buf, n * sizeof(int));
+    memset(d->trans + (size_t)d->nstates * d->nclass, -1, d->nclass * sizeof(int));
+    st->npcs = n;
+    st->at_bol = at_bol;
+    st->anchored = anchored;
+    st->hash = hash;
+    st->accept = anchored ? 0 : d->start_accept;
+
+    // 行在这里结束时，挂起的 $ 都成立，看能否走到 I_MATCH
+    int neol = 0;
+    for (int i = 0; i < n; i++) {
+        if (d->prog[st->pcs[i]].op == I_MATCH) st->accept = 1;
+        if (d->prog[st->pcs[i]].op == I_EOL) d->seeds[neol++] = st->pcs[i];
+    }
+    for (int i = 0; !anchored && i < d->nstart; i++) {
+        if (d->prog[d->start_pcs[i]].op == I_EOL) d->seeds[neol++] = d->start_pcs[i];
+    }
+    st->accept_eol = st->accept;
+    if (!st->accept && neol > 0) {
+        int m = closure(d, d->seeds, neol, at_bol, 1);
+        for (int i = 0; i < m; i++) {
+            if (d->prog[d->buf[i]].op == I_MATCH) st->accept_eol = 1;
+        }
+    }
+
+    // 模式以 ^ 开头时起点闭包为空，离开行首后就再也不会匹配；
+    // 锚定状态要找最长匹配，只在死状态时停
+    if (anchored) d->stop[d->nstates] = n == 0 ? 2 : 0;
+    else d->stop[d->nstates] = st->accept ? 1 : (n == 0 && d->nstart == 0) ? 2 : 0;
+    d->table[slot] = d->nstates + 1;
+    return d->nstates++;
+}
+
+static int start_state(Dfa *d, int anchored, int at_bol) {
+    if (d->start[anchored][at_bol] >= 0) return d->start[anchored][at_bol];
+    int zero = 0;
+    int n = finish_set(d, closure(d, &zero, 1, at_bol, 0), NULL, 0, anchored);
+    int s = intern_state(d, n, at_bol, anchored);
+    if (s < 0) {
+        flush_states(d);
+        n = finish_set(d, closure(d, &zero, 1, at_bol, 0), NULL, 0, anchored);
+        s = intern_state(d, n, at_bol, anchored);
+    }
+    d->start[anchored][at_bol] = s;
+    return s;
+}
+
+// 计算状态 s 读入字节类 cls 后的状态并记入转移表
+static int step(Dfa *d, int s, int cls) {
+    const DState *st = &d->states[s];
+    int anchored = st->anchored;
+    if (!anchored && class_successors(d, cls) != 0) return -1;
+    int rep = d->class_rep[cls];
+    int nseeds = 0;
+    for (int i = 0; i < st->npcs; i++) {
+        const Inst *in = &d->prog[st->pcs[i]];
+        if (in->op == I_CHAR && set_has(&d->sets[in->x], rep)) {
+            d->seeds[nseeds++] = st->pcs[i] + 1;
+        }
+    }
+    int n = closure(d, d->seeds, nseeds, 0, 0);
+    if (anchored) n = finish_set(d, n, NULL, 0, 1);
+    else n = finish_set(d, n, d->class_next[cls], d->class_nnext[cls], 0);
+    int t = intern_state(d, n, 0, anchored);
+    if (t < 0) {
+        // 缓存满了：清空后只保留新状态，原状态 s 已不存在，不记转移
+        flush_states(d);
+        return intern_state(d, n, 0, anchored);
+    }
+    d->trans[(size_t)s * d->nclass + cls] = t;
+    return t;
+}
+
+static int next_state(Dfa *d, int s, int cls) {
+    int t = d->trans[(size_t)s * d->nclass + cls];
+    return t >= 0 ? t : step(d, s, cls);
+}
+
+int dfa_match(Dfa *d, const char *text, size_t len) {
+    const unsigned char *p = (const unsigned char *)text;
+    const unsigned char *end = p + len;
+    int s = start_state(d, 0, 1);
+    if (s < 0) return 0;
+    const unsigned char *byte_class = d->byte_class;
+    int nclass = d->nclass;
+    while (p < end) {
+        // 已匹配，或成了死状态
+        if (d->stop[s]) return d->stop[s] == 1;
+        int cls = byte_class[*p++];
+        int t = d->trans[(size_t)s * nclass + cls];
+        if (t < 0) {
+            t = step(d, s, cls);
+            if (t < 0) return 0;
+        }
+        s = t;
+    }
+    return d->states[s].accept_eol;
+}
+
+// 从 pos 开始的锚定匹配，返回最长匹配的结束位置，没有则返回 -1
+static long longest_at(Dfa *d, const unsigned char *text, size_t len, size_t pos) {
+    int s = start_state(d, 1, pos == 0);
+    long best = -1;
+    for (size_t i = pos; s >= 0; i++) {
+        if (i == len) {
+            if (d->states[s].accept_eol) best = len;
+            break;
+        }
+        if (d->states[s].accept) best = i;
+        if (d->stop[s]) break;
+        s = next_state(d, s, d->byte_class[text[i]]);
+    }
+    return best;
+}
+
+// 反向自动机从行尾往回做一遍未锚定扫描：停在位置 i 时处于接受状态，说明有匹配从 i 开始。
+// 一直扫到 from，最后一个（最靠左的）这样的位置就是最左匹配的起点
+static long leftmost_start(Dfa *r, const unsigned char *text, size_t len, size_t from) {
+    int s = start_state(r, 0, 1);
+    long best = -1;
+    for (size_t i = len; s >= 0; i--) {
+        // 原模式的 ^ 在反向里是 $，只有扫到行首（from 为 0）时才成立
+        const DState *st = &r->states[s];
+        if (i == 0 ? st->accept_eol : st->accept) best = i;
+        if (i == from || r->stop[s] == 2) break;
+        s = next_state(r, s, r->byte_class[text[i - 1]]);
+    }
+    return best;
+}
+
+int dfa_find(Dfa *d, const char *text, size_t len, size_t from, size_t *start, size_t *end) {
+    const unsigned char *p = (const unsigned char *)text;
+    if (!d->reverse && !(d->reverse = compile(d->pattern, d->ignore_case, 1))) return 0;
+
+    // 一遍反向扫描定起点，再从起点做一遍锚定扫描取最长，整体与行长成线性
+    long s = leftmost_start(d->reverse, p, len, from);
+    if (s < 0) return 0;
+    long e = longest_at(d, p, len, s);
+    if (e < 0) return 0;
+    *start = s;
+    *end = e;
+    return 1;
+}
+
+void dfa_free(Dfa *d) {
+    if (!d) return;
+    dfa_free(d->reverse);
+    free(d->pattern);
+    flush_states(d);
+    for (int i = 0; d->class_next && i < d->nclass; i++) {
+        free(d->class_next[i]);
+    }
+    free(d->class_next);
+    free(d->class_nnext);
+    free(d->in_start);
+    free(d->start_pcs);
+    free(d->states);
+    free(d->trans);
+    free(d->stop);
+    free(d->prog);
+    free(d->sets);
+    free(d->stack);
+    free(d->seeds);
+    free(d->buf);
+    free(d->mark);
+    free(d);
+}
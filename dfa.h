@@ -0,0 +1,19 @@
+#ifndef DFA_H
+#define DFA_H
+
+#include <stddef.h>
+
+// 内置正则引擎：ERE 的常用子集先编译成 NFA，匹配时按需构造并缓存 DFA 状态（lazy DFA），
+// 每个输入字节只查一次转移表，耗时与行长成线性，不会像回溯那样在大量 '|' 上退化。
+// 不支持的写法（反向引用、\w、\b、[=a=] 等）编译时返回 NULL，由调用者退回 regexec。
+// 状态缓存在匹配时会被修改，一个 Dfa 只能由一个线程使用
+typedef struct Dfa Dfa;
+
+Dfa *dfa_compile(const char *pattern, int ignore_case);
+// text 是一行（不含换行符，不要求 '\0' 结尾），行内任意位置有匹配返回 1
+int dfa_match(Dfa *dfa, const char *text, size_t len);
+// 从 from 开始找最左最长的匹配 [*start, *end)，没有返回 0；from > 0 时 ^ 不能匹配
+int dfa_find(Dfa *dfa, const char *text, size_t len, size_t from, size_t *start, size_t *end);
+void dfa_free(Dfa *dfa);
+
+#endif
@@ -0,0 +1,81 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/syscall.h>
+#include "dirread.h"
+
+#define DIR_BUF_SIZE (256 * 1024)
+
+// 内核返回的目录项格式，见 getdents64(2)；旧的 glibc 没有 getdents64 的包装，直接走 syscall
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+struct DirReader {
+    int fd;
+    int error;
+    size_t pos, len;
+    DirEntry entry;
+    char buf[DIR_BUF_SIZE];
+};
+
+DirReader *dir_open(int at_fd, const char *path) {
+    int fd = openat(at_fd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+    DirReader *dir = malloc(sizeof(DirReader));
+    if (!dir) {
+        close(fd);
+        errno = ENOMEM;
+        return NULL;
+    }
+    dir->fd = fd;
+    dir->error = 0;
+    dir->pos = dir->len = 0;
+    return dir;
+}
+
+const DirEntry *dir_next(DirReader *dir) {
+    while (1) {
+        if (dir->pos >= dir->len) {
+            long n = syscall(SYS_getdents64, dir->fd, dir->buf, sizeof(dir->buf));
+            if (n <= 0) {
+                if (n < 0) dir->error = errno;
+                return NULL;
+            }
+            dir->pos = 0;
+            dir->len = n;
+        }
+        struct linux_dirent64 *d = (struct linux_dirent64 *)(dir->buf + dir->pos);
+        dir->pos += d->d_reclen;
+        if (d->d_name[0] == '.' &&
+            (d->d_name[1] == '\0' || (d->d_name[1] == '.' && d->d_name[2] == '\0'))) {
+            continue;
+        }
+        dir->entry.name = d->d_name;
+        dir->entry.type = d->d_type;
+        dir->entry.ino = d->d_ino;
+        return &dir->entry;
+    }
+}
+
+int dir_error(const DirReader *dir) {
+    return dir->error;
+}
+
+int dir_fd(const DirReader *dir) {
+    return dir->fd;
+}
+
+void dir_close(DirReader *dir) {
+    if (!dir) return;
+    close(dir->fd);
+    free(dir);
+}
@@ -0,0 +1,25 @@
+#ifndef DIRREAD_H
+#define DIRREAD_H
+
+#include <sys/types.h>
+
+// 目录读取：用 getdents64 一次取一大块目录项，少走系统调用。
+// d_type 已经给出类型，不需要元数据时不必 stat；需要时对 dir_fd() 做 fstatat，
+// 不用拼完整路径再从头解析
+typedef struct DirReader DirReader;
+
+typedef struct {
+    const char *name;
+    unsigned char type;   // DT_DIR、DT_REG 等，文件系统不提供时为 DT_UNKNOWN
+    ino_t ino;
+} DirEntry;
+
+// path 相对 at_fd（可以是 AT_FDCWD）；失败返回 NULL，原因见 errno
+DirReader *dir_open(int at_fd, const char *path);
+// 返回下一项（跳过 . 和 ..），name 在下一次调用前有效；读完或出错返回 NULL，用 dir_error 区分
+const DirEntry *dir_next(DirReader *dir);
+int dir_error(const DirReader *dir);
+int dir_fd(const DirReader *dir);
+void dir_close(DirReader *dir);
+
+#endif
@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "builtin.h"
+#include "walk.h"
+
+#define DU_LINK_BUCKETS 4096
+
+// 硬链接只算一次：记下链接数大于 1 的文件的 (st_dev, st_ino)。
+// 只在调用线程里按输出顺序查，算到哪条路径上与线程调度无关
+typedef struct DuInode {
+    dev_t dev;
+    ino_t ino;
+    struct DuInode *next;
+} DuInode;
+
+typedef struct {
+    int all;              // -a：文件也逐个输出
+    int summarize;        // -s：每个参数只输出合计
+    int human;            // -h：换算成 K / M / G
+    const char *root;     // 当前遍历的参数
+    DuInode *seen[DU_LINK_BUCKETS];
+} DuOptions;
+
+static int has_links(const struct stat *st) {
+    return st->st_nlink > 1 && !S_ISDIR(st->st_mode);
+}
+
+static int first_link(DuOptions *du, const struct stat *st) {
+    if (!has_links(st)) return 1;
+    unsigned long h = ((unsigned long)st->st_dev * 31 + st->st_ino) % DU_LINK_BUCKETS;
+    for (DuInode *n = du->seen[h]; n; n = n->next) {
+        if (n->dev == st->st_dev && n->ino == st->st_ino) return 0;
+    }
+    DuInode *n = malloc(sizeof(DuInode));
+    if (n) {
+        n->dev = st->st_dev;
+        n->ino = st->st_ino;
+        n->next = du->seen[h];
+        du->seen[h] = n;
+    }
+    return 1;
+}
+
+// blocks 以 512 字节为单位；默认按 1K 输出（向上取整），-h 时个位数保留一位小数
+static void print_size(FILE *out, const DuOptions *du, long long blocks, const char *path) {
+    if (!du->human) {
+        fprintf(out, "%lld\t%s\n", (blocks + 1) / 2, path);
+        return;
+    }
+    double size = blocks * 512.0;
+    const char *units = "KMGTPE";
+    if (size < 1024) {
+        fprintf(out, "%.0f\t%s\n", size, path);
+        return;
+    }
+    int u = -1;
+    while (size >= 1024 && units[u + 1]) {
+        size /= 1024;
+        u++;
+    }
+    if (size < 10) {
+        double tenths = (long long)(size * 10);
+        if (tenths < size * 10) tenths++;
+        fprintf(out, "%.1f%c\t%s\n", tenths / 10, units[u], path);
+    } else {
+        long long whole = (long long)size;
+        if (whole < size) whole++;
+        fprintf(out, "%lld%c\t%s\n", whole, units[u], path);
+    }
+}
+
+static long long du_visit_file(const WalkEntry *e, FILE *out, void *ctx, int worker) {
+    (void)worker;
+    DuOptions *du = ctx;
+    struct stat st;
+    const struct stat *stp = e->st;
+    if (!stp) {
+        if (fstatat(e->dirfd, e->name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+            perror(e->path);
+            return 0;
+        }
+        stp = &st;
+    }
+    // 有多个链接的留给 du_drain_file 按输出顺序去重，这里只报块数
+    if (du->all && !du->summarize && !has_links(stp)) print_size(out, du, stp->st_blocks, e->path);
+    return stp->st_blocks;
+}
+
+// 硬链接算在输出顺序里第一次出现的路径上，之后的同一 inode 不再计入也不输出
+static long long du_drain_file(const WalkEntry *e, long long blocks, void *ctx) {
+    DuOptions *du = ctx;
+    if (!e->st || !has_links(e->st)) return blocks;
+    if (!first_link(du, e->st)) return 0;
+    if (du->all && !du->summarize) print_size(stdout, du, blocks, e->path);
+    return blocks;
+}
+
+// 目录自己占的块也算进合计
+static long long du_visit_dir(const WalkEntry *e, FILE *out, void *ctx, int worker) {
+    (void)out;
+    (void)ctx;
+    (void)worker;
+    return e->st ? e->st->st_blocks : 0;
+}
+
+// 子项都算完后输出目录的合计，顺序和 du 一样是先子目录后上级
+static void du_leave_dir(const char *path, long long total, void *ctx) {
+    DuOptions *du = ctx;
+    if (du->summarize && strcmp(path, du->root) != 0) return;
+    print_size(stdout, du, total, path);
+}
+
+int my_du(char **args) {
+    DuOptions du;
+    memset(&du, 0, sizeof(du));
+    int status = 0;
+
+    int argc = 0;
+    while (args[argc]) argc++;
+    char **paths = calloc(argc + 1, sizeof(char *));
+    int path_count = 0;
+    for (int i = 1; args[i]; i++) {
+        if (strcmp(args[i], "-a") == 0) {
+            du.all = 1;
+        } else if (strcmp(args[i], "-s") == 0) {
+            du.summarize = 1;
+        } else if (strcmp(args[i], "-h") == 0) {
+            du.human = 1;
+        } else if (args[i][0] == '-') {
+            fprintf(stderr, "du: unknown option: %s\n", args[i]);
+            fprintf(stderr, "Usage: du [-a] [-s] [-h] [path...]\n");
+            status = 1;
+            goto cleanup;
+        } else {
+            paths[path_count++] = args[i];
+        }
+    }
+    if (path_count == 0) paths[path_count++] = ".";
+
+    for (int i = 0; i < path_count; i++) {
+        struct stat st;
+        if (lstat(paths[i], &st) != 0) {
+            perror(paths[i]);
+            status = 1;
+            continue;
+        }
+        if (!S_ISDIR(st.st_mode)) {
+            if (first_link(&du, &st)) print_size(stdout, &du, st.st_blocks, paths[i]);
+            continue;
+        }
+        // 各个子目录分给多个线程统计，按目录顺序输出
+        WalkOptions w = {0};
+        w.want_stat = 1;
+        w.no_follow = 1;
+        w.visit_file = du_visit_file;
+        w.visit_dir = du_visit_dir;
+        w.leave_dir = du_leave_dir;
+        w.drain_file = du_drain_file;
+        w.ctx = &du;
+        du.root = paths[i];
+        walk_tree(paths[i], &w);
+    }
+
+cleanup:
+    for (int i = 0; i < DU_LINK_BUCKETS; i++) {
+        DuInode *n = du.seen[i];
+        while (n) {
+            DuInode *next = n->next;
+            free(n);
+            n = next;
+        }
+    }
+    free(paths);
+    fflush(stdout);
+    return status;
+}
@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include "eval.h"
+#include "builtin.h"
+
+int shell_exit_requested = 0;
+
+static Arena line_arena;   // 每行的语法树，执行完整体归还
+
+int wait_status(pid_t pid) {
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) return 1;
+    }
+    if (WIFEXITED(status)) return WEXITSTATUS(status);
+    if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+    return 1;
+}
+
+static int eval_node(Node *n);
+
+static int redirect_fd(const char *path, int flags, int target, const char *what) {
+    int fd = open(path, flags, 0644);
+    if (fd < 0) {
+        perror(what);
+        return -1;
+    }
+    dup2(fd, target);
+    close(fd);
+    return 0;
+}
+
+// 子 shell：fork 后在子进程里对括号内的列表求值，cd、alias、exit 都不影响当前 shell
+static int run_subshell(Node *n, int background) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork failed");
+        return 1;
+    }
+    if (pid == 0) {
+        if (n->input_file && redirect_fd(n->input_file, O_RDONLY, STDIN_FILENO, "打开输入文件失败") < 0) {
+            exit(EXIT_FAILURE);
+        }
+        if (n->output_file &&
+            redirect_fd(n->output_file, O_WRONLY | O_CREAT | O_TRUNC, STDOUT_FILENO, "创建输出文件失败") < 0) {
+            exit(EXIT_FAILURE);
+        }
+        int status = eval_node(n->left);
+        fflush(stdout);
+        exit(status);
+    }
+    if (background) {
+        fprintf(stderr, "[PID %d] running in background\n", pid);
+        return 0;
+    }
+    return wait_status(pid);
+}
+
+static int run_background(Node *n) {
+    if (n->type == NODE_PIPELINE) return execute_simple(&line_arena, n->cmds, n->ncmds, 1);
+    if (n->type == NODE_SUBSHELL) return run_subshell(n, 1);
+    // a && b & 这类组合整体放到后台：包成一个子 shell
+    Node group = {NODE_SUBSHELL, NULL, 0, NULL, NULL, n, NULL};
+    return run_subshell(&group, 1);
+}
+
+static int eval_node(Node *n) {
+    int status;
+    switch (n->type) {
+    case NODE_PIPELINE:
+        return execute_simple(&line_arena, n->cmds, n->ncmds, 0);
+    case NODE_SUBSHELL:
+        return run_subshell(n, 0);
+    case NODE_AND:
+        status = eval_node(n->left);
+        if (status != 0 || shell_exit_requested) return status;
+        return eval_node(n->right);
+    case NODE_OR:
+        status = eval_node(n->left);
+        if (status == 0 || shell_exit_requested) return status;
+        return eval_node(n->right);
+    case NODE_SEQ:
+        status = eval_node(n->left);
+        if (shell_exit_requested) return status;
+        return eval_node(n->right);
+    case NODE_BG:
+        return run_background(n->left);
+    }
+    return 0;
+}
+
+int eval_line(const char *line) {
+    const char *error;
+    Node *root = parse_line(&line_arena, line, resolve_alias, &error);
+    int status = 0;
+    if (error) {
+        fprintf(stderr, "语法错误: %s\n", error);
+        status = 2;
+    } else if (root) {
+        status = eval_node(root);
+    }
+    arena_reset(&line_arena);
+    return status;
+}
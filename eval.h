@@ -0,0 +1,22 @@
+#ifndef EVAL_H
+#define EVAL_H
+
+#include <sys/types.h>
+#include "parse.h"
+
+// 命令行的逻辑组合：; & && || 和 ( ) 由 parse.h 解析成语法树，再在 shell 本进程里求值。
+// 叶子是一条简单命令或管道，和单独输入时走同一条执行路径，内置命令照常生效；只有 ( ) 才 fork 出子 shell
+
+// 解析并执行一整行，返回最后一条命令的退出状态；语法错误返回 2
+int eval_line(const char *line);
+
+// 执行一条简单命令或管道，返回退出状态；通配符展开的结果分配在 a 里（由 main.c 提供）
+int execute_simple(Arena *a, SimpleCommand *cmds, int ncmds, int background);
+
+// 等待子进程结束，返回退出状态，被信号终止的为 128 + 信号值
+int wait_status(pid_t pid);
+
+// 执行过 exit 后置 1，调用者应停止执行并退出 shell
+extern int shell_exit_requested;
+
+#endif
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "builtin.h"
+#include "walk.h"
+#include "wildcard.h"
+
+typedef struct {
+    const char *name;           // -name：文件名的通配符，NULL 为不限
+    int type;                   // -type：'f'、'd'、'l'，0 为不限
+    int newer;                  // -newer：只要修改时间晚于参考文件的
+    struct timespec newer_than;
+    int long_list;              // -ls：按 ls -l 的格式输出
+} FindOptions;
+
+// st 为 NULL 时类型看目录项给出的 d_type
+static int find_matches(const FindOptions *f, const char *path, const struct stat *st,
+                        unsigned char d_type) {
+    if (f->name) {
+        const char *slash = strrchr(path, '/');
+        const char *base = slash && slash[1] ? slash + 1 : path;
+        if (!wildcard_match(f->name, base, 0)) return 0;
+    }
+    if (f->type) {
+        int type = st ? (S_ISREG(st->st_mode) ? 'f' : S_ISDIR(st->st_mode) ? 'd' :
+                         S_ISLNK(st->st_mode) ? 'l' : 0)
+                      : (d_type == DT_REG ? 'f' : d_type == DT_DIR ? 'd' :
+                         d_type == DT_LNK ? 'l' : 0);
+        if (type != f->type) return 0;
+    }
+    if (f->newer) {
+        if (!st) return 0;
+        if (st->st_mtim.tv_sec < f->newer_than.tv_sec) return 0;
+        if (st->st_mtim.tv_sec == f->newer_than.tv_sec &&
+            st->st_mtim.tv_nsec <= f->newer_than.tv_nsec) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void find_report(FILE *out, const FindOptions *f, const char *path, const struct stat *st,
+                        unsigned char d_type) {
+    if (!find_matches(f, path, st, d_type)) return;
+    if (f->long_list && st) {
+        print_long_format(out, st, path);
+    } else {
+        fprintf(out, "%s\n", path);
+    }
+}
+
+static long long find_visit(const WalkEntry *e, FILE *out, void *ctx, int worker) {
+    (void)worker;
+    find_report(out, ctx, e->path, e->st, e->d_type);
+    return 0;
+}
+
+int my_find(char **args) {
+    FindOptions f = {0};
+    int argc = 0;
+    while (args[argc]) argc++;
+    char **paths = calloc(argc + 1, sizeof(char *));
+    int path_count = 0;
+    int status = 0;
+
+    // 开头不以 - 开头的参数是起点，其后是条件
+    int i = 1;
+    for (; args[i] && args[i][0] != '-'; i++) {
+        paths[path_count++] = args[i];
+    }
+    for (; args[i]; i++) {
+        if (strcmp(args[i], "-ls") == 0) {
+            f.long_list = 1;
+            continue;
+        }
+        if (strcmp(args[i], "-print") == 0) continue;
+        if (strcmp(args[i], "-name") != 0 && strcmp(args[i], "-type") != 0 &&
+            strcmp(args[i], "-newer") != 0) {
+            fprintf(stderr, "find: unknown predicate: %s\n", args[i]);
+            fprintf(stderr, "Usage: find [path...] [-name GLOB] [-type f|d|l] [-newer FILE] [-ls]\n");
+            status = 1;
+            goto cleanup;
+        }
+        if (!args[i + 1]) {
+            fprintf(stderr, "find: missing argument to %s\n", args[i]);
+            status = 1;
+            goto cleanup;
+        }
+        if (strcmp(args[i], "-name") == 0) {
+            f.name = args[++i];
+        } else if (strcmp(args[i], "-type") == 0) {
+            const char *t = args[++i];
+            if ((t[0] != 'f' && t[0] != 'd' && t[0] != 'l') || t[1] != '\0') {
+                fprintf(stderr, "find: unknown type: %s\n", t);
+                status = 1;
+                goto cleanup;
+            }
+            f.type = t[0];
+        } else if (strcmp(args[i], "-newer") == 0) {
+            struct stat ref;
+            if (stat(args[++i], &ref) != 0) {
+                perror(args[i]);
+                status = 1;
+                goto cleanup;
+            }
+            f.newer = 1;
+            f.newer_than = ref.st_mtim;
+        }
+    }
+    if (path_count == 0) paths[path_count++] = ".";
+
+    for (int p = 0; p < path_count; p++) {
+        struct stat st;
+        if (lstat(paths[p], &st) != 0) {
+            perror(paths[p]);
+            status = 1;
+            continue;
+        }
+        if (!S_ISDIR(st.st_mode)) {
+            find_report(stdout, &f, paths[p], &st, DT_UNKNOWN);
+            continue;
+        }
+        // 不跟随符号链接；类型用目录项里的 d_type，只有 -newer、-ls 才要取每个文件的元数据
+        WalkOptions w = {0};
+        w.want_stat = f.newer || f.long_list;
+        w.no_follow = 1;
+        w.visit_file = find_visit;
+        w.visit_dir = find_visit;
+        w.ctx = &f;
+        walk_tree(paths[p], &w);
+    }
+
+cleanup:
+    free(paths);
+    fflush(stdout);
+    return status;
+}
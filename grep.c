@@ -0,0 +1,975 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <regex.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "builtin.h"
+#include "walk.h"
+#include "aho.h"
+#include "trigram.h"
+#include "dfa.h"
+#include "zread.h"
+#include "ignore.h"
+#include "wildcard.h"
+
+#define COLOR_CYAN    "\x1b[36m"
+#define COLOR_RESET   "\x1b[0m"
+#define GREP_BLOCK_SIZE (256 * 1024)
+#define GREP_BINARY_PROBE (32 * 1024)   // 只在开头这一块里找 NUL
+
+// 一次扫描的状态：缓冲区可以是整个 mmap 的文件，也可以是流式读入的一块
+typedef struct {
+    const char *filename; // 输出行的前缀，标准输入时为 NULL
+    const char *name;     // 提示信息里用的名字
+    GrepOptions *opts;
+    FILE *out;
+    int emit_lines;       // -l / -c 只计数不输出
+    long match_count;
+    long line_num;        // counted 处所在行的行号
+    size_t counted;       // 行号已统计到的偏移
+    size_t printed_end;   // 此前的行都已输出过
+    int after_left;       // -A 倒计数
+    int binary;           // 开头含 NUL，按二进制文件处理
+    int done;             // 已无需继续扫描
+    int max_reached;      // -m 的数量已满
+    regmatch_t *matches;  // 当前输出行上所有匹配的偏移
+    int match_cap;
+} GrepScan;
+
+// 模式中没有任何 ERE 元字符时可按普通子串搜索
+static int is_literal_pattern(const char *pattern) {
+    return strpbrk(pattern, ".[]()*+?{}|^$\\") == NULL;
+}
+
+// 跳过从 p[i]（'['）开始的方括号表达式，返回 ']' 之后的位置
+static size_t skip_bracket(const char *p, size_t i, size_t n) {
+    i++;
+    if (i < n && p[i] == '^') i++;
+    if (i < n && p[i] == ']') i++;   // 紧跟的 ']' 是普通字符
+    while (i < n && p[i] != ']') {
+        if (p[i] == '[' && i + 1 < n && (p[i + 1] == ':' || p[i + 1] == '.' || p[i + 1] == '=')) {
+            char close = p[i + 1];
+            i += 2;
+            while (i + 1 < n && !(p[i] == close && p[i + 1] == ']')) i++;
+            i += 2;
+        } else {
+            i++;
+        }
+    }
+    return i < n ? i + 1 : n;
+}
+
+// 跳过从 p[i]（'('）开始的分组，返回匹配的 ')' 之后的位置
+static size_t skip_group(const char *p, size_t i, size_t n) {
+    int depth = 0;
+    while (i < n) {
+        if (p[i] == '\\') {
+            i += 2;
+            continue;
+        }
+        if (p[i] == '[') {
+            i = skip_bracket(p, i, n);
+            continue;
+        }
+        if (p[i] == '(') depth++;
+        if (p[i] == ')' && --depth == 0) return i + 1;
+        i++;
+    }
+    return n;
+}
+
+// p[i] 处的 '{' 若是合法的重复次数 {m}、{m,}、{m,n}、{,n}（glibc 把 {,n} 当作 {0,n}），
+// 返回 1 并给出最少次数和 '}' 之后的位置
+static int parse_interval(const char *p, size_t i, size_t n, int *min, size_t *next) {
+    size_t j = i + 1;
+    int lo = 0, digits = 0;
+    while (j < n && isdigit((unsigned char)p[j])) {
+        lo = lo * 10 + (p[j++] - '0');
+        digits++;
+    }
+    if (j < n && p[j] == ',') {
+        j++;
+        while (j < n && isdigit((unsigned char)p[j])) {
+            j++;
+            digits++;
+        }
+    }
+    if (!digits || j >= n || p[j] != '}') return 0;
+    *min = lo;
+    *next = j + 1;
+    return 1;
+}
+
+// 从 ERE 中提取每个匹配都必然包含的最长字面串，用来在调用 regexec 前筛掉不可能匹配的行。
+// 只做保守分析：顶层有 '|'、有说不准是不是字面量的 '{'、或找不到字面串时返回 NULL
+static char *required_literal(const char *p, size_t *out_len) {
+    size_t n = strlen(p);
+    for (size_t i = 0; i < n; ) {
+        if (p[i] == '\\') i += 2;
+        else if (p[i] == '[') i = skip_bracket(p, i, n);
+        else if (p[i] == '(') i = skip_group(p, i, n);
+        else if (p[i] == '|') return NULL;
+        else i++;
+    }
+
+    char *best = malloc(n + 1);
+    char *cur = malloc(n + 1);
+    if (!best || !cur) {
+        free(best);
+        free(cur);
+        return NULL;
+    }
+    size_t best_len = 0, cur_len = 0;
+    int uncertain = 0;
+
+    size_t i = 0;
+    while (i < n && !uncertain) {
+        int literal = -1;   // 当前原子若是单个普通字符则为该字符
+        char c = p[i];
+        if (c == '\\' && i + 1 < n) {
+            if (strchr(".[]()*+?{}|^$\\/", p[i + 1])) literal = (unsigned char)p[i + 1];
+            i += 2;
+        } else if (c == '[') {
+            i = skip_bracket(p, i, n);
+        } else if (c == '(') {
+            i = skip_group(p, i, n);
+        } else if (c == '{') {
+            // 原子位置上的 '{' 各实现解释不一，不做推断
+            uncertain = 1;
+            break;
+        } else if (strchr(".^$)*+?", c)) {
+            i++;
+        } else {
+            literal = (unsigned char)c;
+            i++;
+        }
+
+        // 原子后面的量词：可为零次则该字符不是必需的；可重复则之后的字符不再相邻
+        int optional = 0, repeated = 0;
+        while (i < n && (p[i] == '*' || p[i] == '+' || p[i] == '?' || p[i] == '{')) {
+            if (p[i] == '{') {
+                int min;
+                if (!parse_interval(p, i, n, &min, &i)) {
+                    uncertain = 1;
+                    break;
+                }
+                if (min == 0) optional = 1;
+                repeated = 1;
+            } else {
+                if (p[i] != '+') optional = 1;
+                if (p[i] != '?') repeated = 1;
+                i++;
+            }
+        }
+
+        if (literal >= 0 && !optional) cur[cur_len++] = (char)literal;
+        if (literal < 0 || optional || repeated) {
+            if (cur_len > best_len) {
+                memcpy(best, cur, cur_len);
+                best_len = cur_len;
+            }
+            cur_len = 0;
+        }
+    }
+    if (cur_len > best_len) {
+        memcpy(best, cur, cur_len);
+        best_len = cur_len;
+    }
+    free(cur);
+
+    if (best_len == 0 || uncertain) {
+        free(best);
+        return NULL;
+    }
+    best[best_len] = '\0';
+    *out_len = best_len;
+    return best;
+}
+
+// -e / -f 收集到的模式
+typedef struct {
+    char **items;
+    int count;
+    int cap;
+} PatternList;
+
+static void add_pattern(PatternList *list, const char *pattern) {
+    if (list->count == list->cap) {
+        list->cap = list->cap ? list->cap * 2 : 8;
+        list->items = realloc(list->items, list->cap * sizeof(char *));
+    }
+    list->items[list->count++] = strdup(pattern);
+}
+
+static void free_patterns(PatternList *list) {
+    for (int i = 0; i < list->count; i++) {
+        free(list->items[i]);
+    }
+    free(list->items);
+}
+
+// -f FILE：每行一个模式
+static int load_pattern_file(PatternList *list, const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        perror(path);
+        return -1;
+    }
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    while ((len = getline(&line, &cap, fp)) != -1) {
+        if (len > 0 && line[len - 1] == '\n') line[len - 1] = '\0';
+        add_pattern(list, line);
+    }
+    free(line);
+    fclose(fp);
+    return 0;
+}
+
+// 多个正则模式拼成一个 (p1)|(p2)|... 交给 regcomp
+static char *join_patterns(char **patterns, int count) {
+    size_t len = 1;
+    for (int i = 0; i < count; i++) {
+        len += strlen(patterns[i]) + 3;
+    }
+    char *joined = malloc(len);
+    if (!joined) return NULL;
+    char *p = joined;
+    for (int i = 0; i < count; i++) {
+        p += sprintf(p, "%s(%s)", i ? "|" : "", patterns[i]);
+    }
+    return joined;
+}
+
+// 返回值同 grep：有选中的行为 0，没有为 1，出错为 2
+int my_grep(char **args) {
+    GrepOptions opts = {0};
+    PatternList patterns = {0};
+    PatternList includes = {0};    // --include / --exclude：-r 时按文件名筛选
+    PatternList excludes = {0};
+    int status = 2;
+    int quit = 0;
+    int fixed_strings = 0;
+    int explicit_patterns = 0;
+    int use_dfa = 1;
+
+    int argc = 0;
+    while (args[argc]) argc++;
+    char **files = calloc(argc + 1, sizeof(char *));
+    int file_count = 0;
+
+    // 解析参数：不是选项的参数里，第一个是模式（除非用了 -e/-f），其余是文件
+    for (int i = 1; args[i] != NULL; i++) {
+        if (strcmp(args[i], "-i") == 0) {
+            opts.ignore_case = 1;
+        } else if (strcmp(args[i], "-v") == 0) {
+            opts.invert_match = 1;
+        } else if (strcmp(args[i], "-n") == 0) {
+            opts.line_number = 1;
+        } else if (strcmp(args[i], "-c") == 0) {
+            opts.count_only = 1;
+        } else if (strcmp(args[i], "-r") == 0) {
+            opts.recursive = 1;
+        } else if (strcmp(args[i], "-l") == 0) {
+            opts.files_with_matches = 1;
+        } else if (strcmp(args[i], "-o") == 0) {
+            opts.only_matching = 1;
+        } else if (strcmp(args[i], "-E") == 0) {
+            opts.extended_regex = 1;
+        } else if (strcmp(args[i], "-F") == 0) {
+            fixed_strings = 1;
+        } else if (strcmp(args[i], "-I") == 0) {
+            opts.skip_binary = 1;
+        } else if (strcmp(args[i], "-q") == 0) {
+            opts.quiet = 1;
+        } else if (strcmp(args[i], "-m") == 0 && args[i+1] != NULL) {
+            opts.max_count = atol(args[++i]);
+        } else if (strncmp(args[i], "--include=", 10) == 0) {
+            add_pattern(&includes, args[i] + 10);
+        } else if (strncmp(args[i], "--exclude=", 10) == 0) {
+            add_pattern(&excludes, args[i] + 10);
+        } else if (strcmp(args[i], "--no-ignore") == 0) {
+            opts.no_ignore = 1;
+        } else if (strncmp(args[i], "--regex-engine=", 15) == 0) {
+            // dfa：内置引擎，不支持的模式自动退回 regexec；libc：总是用 regexec
+            if (strcmp(args[i] + 15, "dfa") == 0) {
+                use_dfa = 1;
+            } else if (strcmp(args[i] + 15, "libc") == 0) {
+                use_dfa = 0;
+            } else {
+                fprintf(stderr, "grep: unknown regex engine: %s\n", args[i] + 15);
+                goto cleanup;
+            }
+        } else if (strcmp(args[i], "-e") == 0 && args[i+1] != NULL) {
+            add_pattern(&patterns, args[++i]);
+            explicit_patterns = 1;
+        } else if (strcmp(args[i], "-f") == 0 && args[i+1] != NULL) {
+            if (load_pattern_file(&patterns, args[++i]) != 0) goto cleanup;
+            explicit_patterns = 1;
+        } else if (strcmp(args[i], "-A") == 0 && args[i+1] != NULL) {
+            opts.after_context = 1;
+            opts.context_lines = atoi(args[i+1]);
+            i++;
+        } else if (strcmp(args[i], "-B") == 0 && args[i+1] != NULL) {
+            opts.before_context = 1;
+            opts.context_lines = atoi(args[i+1]);
+            i++;
+        } else if (args[i][0] != '-' || strcmp(args[i], "-") == 0) {
+            files[file_count++] = args[i];
+        }
+    }
+    if (!explicit_patterns && file_count > 0) {
+        add_pattern(&patterns, files[0]);
+        memmove(files, files + 1, file_count * sizeof(char *));
+        file_count--;
+    }
+
+    // 检查参数有效性
+    if (patterns.count == 0) {
+        fprintf(stderr, "Usage: grep [-i] [-v] [-n] [-c] [-r] [-l] [-o] [-E] [-F] [-I] [-q] [-m num] [-A num] [-B num] "
+                        "[--include=glob] [--exclude=glob] [--no-ignore] [--regex-engine=dfa|libc] {pattern | -e pattern... | -f file} [file...]\n");
+        goto cleanup;
+    }
+
+    int all_fixed = 1;
+    for (int i = 0; i < patterns.count && !fixed_strings; i++) {
+        if (!is_literal_pattern(patterns.items[i])) all_fixed = 0;
+    }
+
+    regex_t regex;
+    char *joined = NULL;
+    char *required = NULL;
+    if (all_fixed && patterns.count == 1 && !opts.ignore_case) {
+        // 单个字面量：memmem 快速路径
+        opts.pattern = patterns.items[0];
+        opts.literal = 1;
+        opts.required = opts.pattern;
+        opts.required_len = strlen(opts.pattern);
+    } else if (all_fixed) {
+        // 一组固定字符串：Aho-Corasick 一遍扫描全部匹配
+        opts.pattern = patterns.count == 1 ? patterns.items[0] : NULL;
+        opts.ac = ac_build(patterns.items, patterns.count, opts.ignore_case);
+        if (!opts.ac) {
+            perror("grep");
+            goto cleanup;
+        }
+    } else {
+        // 处理正则表达式
+        if (patterns.count == 1) {
+            opts.pattern = patterns.items[0];
+        } else {
+            joined = join_patterns(patterns.items, patterns.count);
+            opts.pattern = joined;
+        }
+        opts.reg_flags = REG_EXTENDED | (opts.ignore_case ? REG_ICASE : 0);
+        if (!opts.pattern || regcomp(&regex, opts.pattern, opts.reg_flags) != 0) {
+            fprintf(stderr, "Invalid regular expression\n");
+            free(joined);
+            goto cleanup;
+        }
+        opts.regex = &regex;
+        if (use_dfa) opts.dfa = dfa_compile(opts.pattern, opts.ignore_case);
+
+        // 预筛选用的必需字面串
+        if (!opts.ignore_case) {
+            required = required_literal(opts.pattern, &opts.required_len);
+            opts.required = required;
+        }
+    }
+
+    // 给 -r 查三元组索引用的字面串：每个模式各取一个必需字面串，任一模式拿不到就不限定
+    char **index_literals = calloc(patterns.count, sizeof(char *));
+    if (index_literals && !opts.invert_match) {
+        for (int i = 0; i < patterns.count; i++) {
+            size_t len;
+            index_literals[i] = all_fixed ? strdup(patterns.items[i])
+                                          : required_literal(patterns.items[i], &len);
+        }
+        opts.index_literals = index_literals;
+        opts.index_literal_count = patterns.count;
+    }
+
+    opts.include = includes.items;
+    opts.include_count = includes.count;
+    opts.exclude = excludes.items;
+    opts.exclude_count = excludes.count;
+
+    // -q 时任一文件命中即可结束，多线程遍历也通过这个标志提前收工
+    if (opts.quiet) opts.quit = &quit;
+
+    // 处理文件参数，没有文件时读标准输入
+    if (file_count == 0) {
+        process_stdin(&opts, stdout);
+    }
+    for (int i = 0; i < file_count && !quit; i++) {
+        if (strcmp(files[i], "-") == 0) process_stdin(&opts, stdout);
+        else process_file_or_dir(files[i], &opts);
+    }
+    if (opts.selected > 0) status = 0;
+    else status = opts.had_error ? 2 : 1;
+
+    for (int i = 0; index_literals && i < patterns.count; i++) {
+        free(index_literals[i]);
+    }
+    free(index_literals);
+    if (opts.regex) regfree(&regex);
+    dfa_free(opts.dfa);
+    ac_free(opts.ac);
+    free(required);
+    free(joined);
+
+cleanup:
+    free_patterns(&patterns);
+    free_patterns(&includes);
+    free_patterns(&excludes);
+    free(files);
+    return status;
+}
+
+// 辅助函数：处理文件或目录
+void process_file_or_dir(const char *path, GrepOptions *opts) {
+    struct stat statbuf;
+    if (stat(path, &statbuf) != 0) {
+        perror(path);
+        opts->had_error = 1;
+        return;
+    }
+
+    if (S_ISDIR(statbuf.st_mode)) {
+        if (opts->recursive) {
+            process_directory(path, opts);
+        } else {
+            fprintf(stderr, "grep: %s: Is a directory\n", path);
+            opts->had_error = 1;
+        }
+    } else {
+        process_file(path, opts, stdout);
+    }
+}
+
+static void grep_file_at(int dirfd, const char *name, const char *path, GrepOptions *opts, FILE *out);
+
+static long long grep_visit_file(const WalkEntry *e, FILE *out, void *ctx, int worker) {
+    GrepOptions *opts = &((GrepOptions *)ctx)[worker];
+    if (strcmp(e->name, TRIGRAM_INDEX_NAME) == 0) return 0;
+
+    // 有索引时先查候选：未变化且不含所需三元组的文件不必打开
+    struct stat st;
+    const struct stat *stp = e->st;
+    if (opts->index && !stp && fstatat(e->dirfd, e->name, &st, 0) == 0) stp = &st;
+    if (opts->index && stp &&
+        !tri_may_match(opts->index, e->path + opts->index_root_len, stp)) {
+        if (opts->count_only && !opts->quiet && !opts->files_with_matches) {
+            fprintf(out, "%s:0\n", e->path);
+        }
+        return 0;
+    }
+    grep_file_at(e->dirfd, e->name, e->path, opts, out);
+    return 0;
+}
+
+// 进入目录时读取其忽略规则，子目录继承
+static void *grep_enter_dir(const char *path, int dirfd, void *parent, void *ctx) {
+    GrepOptions *opts = ctx;
+    return ignore_load(opts->ignore, parent, path, dirfd);
+}
+
+// 在打开前剪掉：--include / --exclude 按文件名过滤文件；
+// 被忽略的文件和目录剪掉，.git 目录总是跳过（--no-ignore 时都不做）
+static int grep_skip_entry(const char *path, int is_dir, void *dir_ctx, void *ctx) {
+    GrepOptions *opts = ctx;
+    const char *slash = strrchr(path, '/');
+    const char *name = slash ? slash + 1 : path;
+    if (!is_dir) {
+        int included = opts->include_count == 0;
+        for (int i = 0; i < opts->include_count && !included; i++) {
+            if (wildcard_match(opts->include[i], name, 0)) included = 1;
+        }
+        if (!included) return 1;
+        for (int i = 0; i < opts->exclude_count; i++) {
+            if (wildcard_match(opts->exclude[i], name, 0)) return 1;
+        }
+    }
+    if (opts->no_ignore) return 0;
+    if (is_dir && strcmp(name, ".git") == 0) return 1;
+    return ignore_match(dir_ctx, path, is_dir);
+}
+
+// 辅助函数：处理目录（多线程遍历，输出按文件名顺序拼接）
+void process_directory(const char *dirpath, GrepOptions *opts) {
+    int threads = walk_default_threads();
+
+    // glibc 的 regexec 对同一个 regex_t 加锁串行执行，每个线程编译一份自己的
+    GrepOptions *per_worker = calloc(threads, sizeof(GrepOptions));
+    regex_t *regexes = calloc(threads, sizeof(regex_t));
+    if (!per_worker || !regexes) {
+        perror("grep");
+        free(per_worker);
+        free(regexes);
+        return;
+    }
+    TrigramIndex *index = opts->index_literals ? tri_load(dirpath) : NULL;
+    if (index && !tri_restrict(index, opts->index_literals, opts->index_literal_count)) {
+        tri_free(index);
+        index = NULL;
+    }
+
+    IgnoreSet ignore;
+    ignore_set_init(&ignore);
+
+    int compiled = 0;
+    for (int i = 0; i < threads; i++) {
+        per_worker[i] = *opts;
+        per_worker[i].ignore = &ignore;
+        per_worker[i].index = index;
+        per_worker[i].index_root_len = strlen(dirpath) + 1;
+        per_worker[i].selected = 0;
+        per_worker[i].had_error = 0;
+    }
+    // DFA 的状态缓存同样不能共享，有 DFA 时每个线程编译自己的 DFA，否则编译 regex
+    for (; opts->dfa && compiled < threads; compiled++) {
+        per_worker[compiled].dfa = dfa_compile(opts->pattern, opts->ignore_case);
+        if (!per_worker[compiled].dfa) break;
+    }
+    for (; !opts->dfa && opts->regex && compiled < threads; compiled++) {
+        if (regcomp(&regexes[compiled], opts->pattern, opts->reg_flags) != 0) break;
+        per_worker[compiled].regex = &regexes[compiled];
+    }
+
+    // 编译到一半失败（多半是内存不够）时少开几个线程；一个都没编译成就报错，不能悄悄跳过整棵树
+    int workers = opts->regex ? compiled : threads;
+    if (workers == 0) {
+        fprintf(stderr, "grep: %s: cannot compile the pattern for worker threads\n", dirpath);
+        opts->had_error = 1;
+    } else {
+        WalkOptions w = {0};
+        w.threads = workers;
+        w.visit_file = grep_visit_file;
+        w.want_stat = opts->index != NULL;
+        if (!opts->no_ignore) w.enter_dir = grep_enter_dir;
+        w.skip_entry = grep_skip_entry;
+        w.ctx = per_worker;
+        walk_tree(dirpath, &w);
+    }
+
+    // 汇总各线程的结果
+    for (int i = 0; i < threads; i++) {
+        opts->selected += per_worker[i].selected;
+        opts->had_error |= per_worker[i].had_error;
+    }
+
+    for (int i = 0; i < compiled; i++) {
+        if (opts->dfa) dfa_free(per_worker[i].dfa);
+        else regfree(&regexes[i]);
+    }
+    ignore_set_free(&ignore);
+    tri_free(index);
+    free(regexes);
+    free(per_worker);
+}
+
+// 用正则确认一行：有 DFA 时走 DFA，否则 regexec
+static int regex_matches(GrepOptions *opts, const char *line, size_t len) {
+    if (opts->dfa) return dfa_match(opts->dfa, line, len);
+    regmatch_t range;
+    range.rm_so = 0;
+    range.rm_eo = len;
+    return regexec(opts->regex, line, 0, &range, REG_STARTEND) == 0;
+}
+
+// 单行匹配：行不含换行符，也不要求以 '\0' 结尾
+static int line_matches(GrepOptions *opts, const char *line, size_t len) {
+    int matched;
+    if (opts->ac) {
+        matched = ac_search(opts->ac, line, len) != NULL;
+    } else if (opts->required && !memmem(line, len, opts->required, opts->required_len)) {
+        // 连必需的字面串都没有，不可能匹配
+        matched = 0;
+    } else if (opts->literal) {
+        matched = 1;
+    } else {
+        matched = regex_matches(opts, line, len);
+    }
+    return opts->invert_match ? !matched : matched;
+}
+
+// 在 [pos, end) 中找下一条要选中的行，返回行首，*line_end 为换行符位置（或 end）
+static int find_next_line(GrepOptions *opts, const char *buf, size_t pos, size_t end,
+                          size_t *line_start, size_t *line_end) {
+    if (opts->ac && !opts->invert_match) {
+        // 模式集：自动机一遍扫过整个缓冲区，命中后再找行边界
+        const char *hit = ac_search(opts->ac, buf + pos, end - pos);
+        if (!hit) return 0;
+        if (hit > buf + pos) hit--;   // 指向匹配的最后一个字节（空模式时为 pos）
+        const char *nl = memrchr(buf + pos, '\n', hit - (buf + pos));
+        *line_start = nl ? (size_t)(nl - buf) + 1 : pos;
+        nl = memchr(hit, '\n', buf + end - hit);
+        *line_end = nl ? (size_t)(nl - buf) : end;
+        return 1;
+    }
+
+    if (opts->required && !opts->invert_match) {
+        // 快速路径：memmem 直接跳到必需字面串的命中处，再向两边找行边界，
+        // 只有这样的候选行才需要交给正则确认
+        while (pos < end) {
+            const char *hit = memmem(buf + pos, end - pos, opts->required, opts->required_len);
+            if (!hit) return 0;
+            const char *nl = memrchr(buf + pos, '\n', hit - (buf + pos));
+            size_t ls = nl ? (size_t)(nl - buf) + 1 : pos;
+            nl = memchr(hit, '\n', buf + end - hit);
+            size_t le = nl ? (size_t)(nl - buf) : end;
+
+            if (opts->literal || regex_matches(opts, buf + ls, le - ls)) {
+                *line_start = ls;
+                *line_end = le;
+                return 1;
+            }
+            pos = le + 1;
+        }
+        return 0;
+    }
+
+    while (pos < end) {
+        const char *nl = memchr(buf + pos, '\n', end - pos);
+        size_t le = nl ? (size_t)(nl - buf) : end;
+        if (line_matches(opts, buf + pos, le - pos)) {
+            *line_start = pos;
+            *line_end = le;
+            return 1;
+        }
+        pos = le + 1;
+    }
+    return 0;
+}
+
+// 把行号统计推进到 off（只向前数）
+static void count_lines_to(GrepScan *s, const char *buf, size_t off) {
+    if (!s->opts->line_number) return;
+    const char *p = buf + s->counted;
+    const char *stop = buf + off;
+    while (p < stop && (p = memchr(p, '\n', stop - p)) != NULL) {
+        s->line_num++;
+        p++;
+    }
+    s->counted = off;
+}
+
+// 在一行的 [from, len) 中找最左最长的匹配，各种匹配方式统一给出 regmatch_t 式的偏移
+static int next_match(GrepOptions *opts, const char *line, size_t len, size_t from, regmatch_t *m) {
+    size_t so, eo;
+    if (opts->ac) {
+        if (!ac_find(opts->ac, line + from, len - from, &so, &eo)) return 0;
+        so += from;
+        eo += from;
+    } else if (opts->literal) {
+        const char *hit = memmem(line + from, len - from, opts->required, opts->required_len);
+        if (!hit) return 0;
+        so = hit - line;
+        eo = so + opts->required_len;
+    } else if (opts->dfa) {
+        if (!dfa_find(opts->dfa, line, len, from, &so, &eo)) return 0;
+    } else {
+        // 从行中间接着找时 ^ 不能再匹配
+        m->rm_so = from;
+        m->rm_eo = len;
+        return regexec(opts->regex, line, 1, m, REG_STARTEND | (from ? REG_NOTBOL : 0)) == 0;
+    }
+    m->rm_so = so;
+    m->rm_eo = eo;
+    return 1;
+}
+
+// 收集一行上所有不重叠的匹配，供 -o 和高亮使用；空匹配跳过
+static int collect_matches(GrepScan *s, const char *line, size_t len) {
+    int n = 0;
+    size_t pos = 0;
+    regmatch_t m;
+    while (pos <= len && next_match(s->opts, line, len, pos, &m)) {
+        if (m.rm_eo == m.rm_so) {
+            pos = m.rm_so + 1;
+            continue;
+        }
+        if (n == s->match_cap) {
+            int cap = s->match_cap ? s->match_cap * 2 : 16;
+            regmatch_t *grown = realloc(s->matches, cap * sizeof(regmatch_t));
+            if (!grown) break;
+            s->matches = grown;
+            s->match_cap = cap;
+        }
+        s->matches[n++] = m;
+        pos = m.rm_eo;
+    }
+    return n;
+}
+
+static void emit_line(GrepScan *s, const char *buf, size_t ls, size_t le,
+                      long line_num, int is_match) {
+    int nmatch = 0;
+    if (is_match && !s->opts->invert_match) nmatch = collect_matches(s, buf + ls, le - ls);
+    print_line(s->out, s->filename, line_num, buf + ls, le - ls, s->opts->line_number,
+               s->opts->only_matching, s->matches, nmatch);
+    s->printed_end = le + 1;
+}
+
+// 输出 [pos, limit) 中 -A 还欠着的后置上下文行
+static void emit_after_context(GrepScan *s, const char *buf, size_t pos, size_t limit) {
+    while (s->after_left > 0 && pos < limit) {
+        const char *nl = memchr(buf + pos, '\n', limit - pos);
+        size_t le = nl ? (size_t)(nl - buf) : limit;
+        count_lines_to(s, buf, pos);
+        emit_line(s, buf, pos, le, s->line_num, 0);
+        s->after_left--;
+        pos = le + 1;
+    }
+}
+
+// 从行首 ls 往回数最多 n 行，不越过 lower，返回最早那一行的行首
+static size_t back_lines(const char *buf, size_t ls, size_t lower, int n) {
+    size_t p = ls;
+    for (int k = 0; k < n && p > lower; k++) {
+        const char *nl = memrchr(buf + lower, '\n', p - 1 - lower);
+        p = nl ? (size_t)(nl - buf) + 1 : lower;
+    }
+    return p;
+}
+
+// 扫描 buf[start, end)，end 落在行边界上；buf[0, start) 是可用作 -B 上下文的旧行
+static void grep_buffer(GrepScan *s, const char *buf, size_t start, size_t end) {
+    GrepOptions *opts = s->opts;
+    int before = (opts->before_context && s->emit_lines) ? opts->context_lines : 0;
+    size_t pos = start;
+    size_t ls, le;
+
+    while (!s->done && !s->max_reached && pos < end &&
+           find_next_line(opts, buf, pos, end, &ls, &le)) {
+        s->match_count++;
+        if (opts->max_count > 0 && s->match_count >= opts->max_count) {
+            s->max_reached = 1;
+        }
+        if (!s->emit_lines && (opts->quiet || opts->files_with_matches || s->max_reached)) {
+            // -q / -l 只需知道有没有命中，-m 数够了也不必再往下扫
+            if (opts->quit) __atomic_store_n(opts->quit, 1, __ATOMIC_RELAXED);
+            s->done = 1;
+            break;
+        }
+        if (s->binary && s->emit_lines) {
+            // 二进制文件不输出内容，第一次命中就可以结束
+            fprintf(s->out, "Binary file %s matches\n", s->name);
+            s->done = 1;
+            break;
+        }
+        if (s->emit_lines) {
+            emit_after_context(s, buf, pos, ls);
+
+            // 前置上下文：从匹配行往回找，已输出的行不再重复
+            size_t lower = s->printed_end < ls ? s->printed_end : ls;
+            size_t p = before > 0 ? back_lines(buf, ls, lower, before) : ls;
+            count_lines_to(s, buf, ls);
+            long match_num = s->line_num;
+            if (p < ls) {
+                long n = 0;
+                for (size_t q = p; q < ls; q++) {
+                    if (buf[q] == '\n') n++;
+                }
+                while (p < ls) {
+                    const char *nl = memchr(buf + p, '\n', ls - p);
+                    emit_line(s, buf, p, nl - buf, match_num - n--, 0);
+                    p = nl - buf + 1;
+                }
+            }
+
+            emit_line(s, buf, ls, le, match_num, 1);
+            s->after_left = opts->after_context ? opts->context_lines : 0;
+        }
+        pos = le + 1;
+    }
+
+    if (s->emit_lines && !s->done) emit_after_context(s, buf, pos, end);
+    // -m 数够后只把最后一个匹配的 -A 上下文输出完
+    if (s->max_reached && s->after_left == 0) s->done = 1;
+}
+
+static int looks_binary(const char *buf, size_t len) {
+    return memchr(buf, '\0', len < GREP_BINARY_PROBE ? len : GREP_BINARY_PROBE) != NULL;
+}
+
+// 非普通文件（管道、设备等）、压缩文件或 mmap 失败时：大块读入（z 非 NULL 时边读边解压），
+// 跨块保留 -B 需要的尾部行
+static void grep_fd_stream(GrepScan *s, int fd, ZReader *z) {
+    size_t cap = GREP_BLOCK_SIZE;
+    char *buf = malloc(cap);
+    if (!buf) {
+        perror("grep");
+        return;
+    }
+    int before = (s->opts->before_context && s->emit_lines) ? s->opts->context_lines : 0;
+    size_t have = 0, start = 0;
+    int probed = 0;
+
+    while (!s->done) {
+        if (have == cap) {
+            // 一行比缓冲区还长：扩容
+            char *grown = realloc(buf, cap * 2);
+            if (!grown) {
+                perror("grep");
+                break;
+            }
+            buf = grown;
+            cap *= 2;
+        }
+        ssize_t n = z ? z_read(z, buf + have, cap - have) : read(fd, buf + have, cap - have);
+        if (n < 0) {
+            if (z) fprintf(stderr, "grep: %s: %s\n", s->name, z_error(z));
+            else perror(s->name);
+            s->opts->had_error = 1;
+            break;
+        }
+        int eof = (n == 0);
+        have += n;
+
+        if (!probed) {
+            probed = 1;
+            s->binary = looks_binary(buf, have);
+            if (s->binary && s->opts->skip_binary) {
+                s->done = 1;
+                break;
+            }
+        }
+
+        size_t end = have;
+        if (!eof) {
+            const char *nl = memrchr(buf + start, '\n', have - start);
+            if (!nl) continue;
+            end = nl - buf + 1;
+        }
+        if (end > start) grep_buffer(s, buf, start, end);
+        if (eof) break;
+
+        // 丢弃已处理的部分，只留下 -B 可能用到的行和尚未完整的末行
+        count_lines_to(s, buf, end);
+        size_t lower = s->printed_end < end ? s->printed_end : end;
+        size_t keep = before > 0 ? back_lines(buf, end, lower, before) : end;
+        memmove(buf, buf + keep, have - keep);
+        have -= keep;
+        start = end - keep;
+        s->printed_end = s->printed_end > keep ? s->printed_end - keep : 0;
+        s->counted = s->counted > keep ? s->counted - keep : 0;
+    }
+    free(buf);
+}
+
+// 对已打开的 fd 执行匹配；filename 为 NULL 表示标准输入，输出行不带文件名前缀
+static void grep_fd(int fd, const char *filename, GrepOptions *opts, FILE *out) {
+    const char *name = filename ? filename : "(standard input)";
+    GrepScan s = {0};
+    s.filename = filename;
+    s.name = name;
+    s.opts = opts;
+    s.out = out;
+    s.emit_lines = !opts->files_with_matches && !opts->count_only && !opts->quiet;
+    s.line_num = 1;
+
+    // 普通文件（包括重定向进来的标准输入）整体映射进内存，匹配器直接在映射上找行边界；
+    // gzip / zstd 压缩的文件按魔数识别，流式解压后走分块读取
+    struct stat st;
+    void *map = MAP_FAILED;
+    ZReader *z = NULL;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+        lseek(fd, 0, SEEK_CUR) == 0) {
+        // 先读开头一块判断是否压缩、是否二进制，-I 时不必映射整个文件
+        char probe[GREP_BINARY_PROBE];
+        ssize_t got = pread(fd, probe, sizeof(probe), 0);
+        int format = got > 0 ? z_detect((unsigned char *)probe, got) : Z_FORMAT_NONE;
+        if (format != Z_FORMAT_NONE) {
+            z = z_open(fd, format);
+            if (!z) {
+                perror(name);
+                opts->had_error = 1;
+                return;
+            }
+        } else {
+            s.binary = got > 0 && looks_binary(probe, got);
+            if (s.binary && opts->skip_binary) return;
+            map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+    }
+    if (map != MAP_FAILED) {
+        madvise(map, st.st_size, MADV_SEQUENTIAL);
+        grep_buffer(&s, map, 0, st.st_size);
+        munmap(map, st.st_size);
+    } else {
+        // 压缩文件是否二进制看解压出来的第一块
+        grep_fd_stream(&s, fd, z);
+        z_close(z);
+    }
+    free(s.matches);
+    if (s.binary && opts->skip_binary) return;
+    opts->selected += s.match_count;
+
+    // 处理 -l 和 -c
+    if (opts->quiet) {
+        return;
+    } else if (opts->files_with_matches) {
+        if (s.match_count > 0) fprintf(out, "%s\n", name);
+    } else if (opts->count_only) {
+        if (filename) fprintf(out, "%s:%ld\n", filename, s.match_count);
+        else fprintf(out, "%ld\n", s.match_count);
+    }
+}
+
+// 打开 dirfd 下的 name（path 用于输出）；遍历时相对目录描述符打开，不再解析整条路径
+static void grep_file_at(int dirfd, const char *name, const char *path, GrepOptions *opts, FILE *out) {
+    if (opts->quit && __atomic_load_n(opts->quit, __ATOMIC_RELAXED)) return;
+
+    int fd = openat(dirfd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror(path);
+        opts->had_error = 1;
+        return;
+    }
+    grep_fd(fd, path, opts, out);
+    close(fd);
+}
+
+void process_file(const char *filename, GrepOptions *opts, FILE *out) {
+    grep_file_at(AT_FDCWD, filename, filename, opts, out);
+}
+
+// 管道或重定向：从标准输入读，与文件走同一套匹配和分块读取逻辑
+void process_stdin(GrepOptions *opts, FILE *out) {
+    grep_fd(STDIN_FILENO, NULL, opts, out);
+}
+
+// 辅助函数：打印一行（line 不含换行符），matches 是行内各匹配的偏移。
+// -o 时每个匹配单独输出一行，否则整行输出并高亮全部匹配；上下文行没有匹配
+void print_line(FILE *out, const char *filename, long line_num, const char *line, size_t len,
+                int show_line_number, int only_matching, const regmatch_t *matches, int nmatch) {
+    if (only_matching) {
+        for (int i = 0; i < nmatch; i++) {
+            if (filename) fprintf(out, "%s:", filename);
+            if (show_line_number) fprintf(out, "%ld:", line_num);
+            fprintf(out, "%.*s\n", (int)(matches[i].rm_eo - matches[i].rm_so), line + matches[i].rm_so);
+        }
+        return;
+    }
+
+    if (filename) fprintf(out, "%s:", filename);
+    if (show_line_number) fprintf(out, "%ld:", line_num);
+    size_t pos = 0;
+    for (int i = 0; i < nmatch; i++) {
+        // 打印匹配前的部分，再打印带颜色的匹配部分
+        fprintf(out, "%.*s", (int)(matches[i].rm_so - pos), line + pos);
+        fprintf(out, "%s%.*s%s", COLOR_CYAN, (int)(matches[i].rm_eo - matches[i].rm_so),
+                line + matches[i].rm_so, COLOR_RESET);
+        pos = matches[i].rm_eo;
+    }
+    fprintf(out, "%.*s\n", (int)(len - pos), line + pos);
+}
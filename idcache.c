@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <pwd.h>
+#include <grp.h>
+#include "idcache.h"
+
+#define ID_BUCKETS 256
+#define ID_BUF_MAX (64 << 20)   // 很大的 LDAP / AD 组成员列表也放得下
+
+typedef struct IdEntry {
+    unsigned id;
+    char *name;          // 查不到时是数字
+    char *home;          // 只有用户有，查不到为 NULL
+    time_t loaded;
+    int resolved;        // 0：上次查询碰上暂时性错误，名字只是临时的数字，下次再查
+    struct IdEntry *next;
+} IdEntry;
+
+typedef struct {
+    IdEntry *buckets[ID_BUCKETS];
+} IdTable;
+
+static IdTable users, groups;
+static pthread_mutex_t id_lock = PTHREAD_MUTEX_INITIALIZER;
+static long id_ttl = -1;   // 秒，0 表示不过期；-1 表示还没读环境变量
+
+static long cache_ttl(void) {
+    if (id_ttl < 0) {
+        const char *env = getenv("DESHELL_ID_CACHE_TTL");
+        id_ttl = env ? atol(env) : 0;
+        if (id_ttl < 0) id_ttl = 0;
+    }
+    return id_ttl;
+}
+
+static size_t initial_buf_size(int name) {
+    long n = sysconf(name);
+    return n > 0 ? (size_t)n : 16384;
+}
+
+// 返回 0 或 ENOENT 等表示确实没有这个 id；缓冲加到上限仍 ERANGE、EIO、ENOMEM（如目录服务连不上）都算暂时的
+static int lookup_definitive(int rc) {
+    return rc == 0 || rc == ENOENT || rc == ESRCH || rc == EBADF || rc == EPERM;
+}
+
+// 名字变了时旧字符串不释放：别的线程可能还拿着它
+static void set_string(char **slot, const char *value) {
+    if (*slot && value && strcmp(*slot, value) == 0) return;
+    *slot = value ? strdup(value) : NULL;
+}
+
+// 缓冲不够（ERANGE）时加倍重试；sysconf 给的初始大小常常只有 1024，大的组一次放不下
+static void load_user(IdEntry *e) {
+    size_t size = initial_buf_size(_SC_GETPW_R_SIZE_MAX);
+    char *buf = NULL;
+    struct passwd pw, *result = NULL;
+    int rc;
+    do {
+        char *grown = realloc(buf, size);
+        if (!grown) {
+            rc = ENOMEM;
+            break;
+        }
+        buf = grown;
+        rc = getpwuid_r(e->id, &pw, buf, size, &result);
+        size *= 2;
+    } while (rc == ERANGE && size <= ID_BUF_MAX);
+    e->resolved = result != NULL || lookup_definitive(rc);
+    // 暂时性错误时已有的名字（TTL 到期重查）照旧保留，没有才先用数字顶上
+    if (e->resolved || !e->name) {
+        char num[16];
+        snprintf(num, sizeof(num), "%u", e->id);
+        set_string(&e->name, result ? result->pw_name : num);
+        set_string(&e->home, result ? result->pw_dir : NULL);
+    }
+    free(buf);
+}
+
+static void load_group(IdEntry *e) {
+    size_t size = initial_buf_size(_SC_GETGR_R_SIZE_MAX);
+    char *buf = NULL;
+    struct group gr, *result = NULL;
+    int rc;
+    do {
+        char *grown = realloc(buf, size);
+        if (!grown) {
+            rc = ENOMEM;
+            break;
+        }
+        buf = grown;
+        rc = getgrgid_r(e->id, &gr, buf, size, &result);
+        size *= 2;
+    } while (rc == ERANGE && size <= ID_BUF_MAX);
+    e->resolved = result != NULL || lookup_definitive(rc);
+    // 暂时性错误时已有的名字（TTL 到期重查）照旧保留，没有才先用数字顶上
+    if (e->resolved || !e->name) {
+        char num[16];
+        snprintf(num, sizeof(num), "%u", e->id);
+        set_string(&e->name, result ? result->gr_name : num);
+    }
+    free(buf);
+}
+
+// 查询在锁内做，同一个 id 不会被几个线程重复查询
+static IdEntry *lookup(IdTable *table, unsigned id, void (*load)(IdEntry *)) {
+    pthread_mutex_lock(&id_lock);
+    IdEntry **slot = &table->buckets[id % ID_BUCKETS];
+    IdEntry *e = *slot;
+    while (e && e->id != id) e = e->next;
+    time_t now = time(NULL);
+    if (!e) {
+        e = calloc(1, sizeof(IdEntry));
+        if (!e) {
+            pthread_mutex_unlock(&id_lock);
+            return NULL;
+        }
+        e->id = id;
+        load(e);
+        e->loaded = now;
+        e->next = *slot;
+        *slot = e;
+    } else if (!e->resolved || (cache_ttl() > 0 && now - e->loaded >= cache_ttl())) {
+        load(e);
+        e->loaded = now;
+    }
+    pthread_mutex_unlock(&id_lock);
+    return e;
+}
+
+const char *id_user_name(uid_t uid) {
+    IdEntry *e = lookup(&users, uid, load_user);
+    return e && e->name ? e->name : "?";
+}
+
+const char *id_group_name(gid_t gid) {
+    IdEntry *e = lookup(&groups, gid, load_group);
+    return e && e->name ? e->name : "?";
+}
+
+const char *id_user_home(uid_t uid) {
+    IdEntry *e = lookup(&users, uid, load_user);
+    return e ? e->home : NULL;
+}
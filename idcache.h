@@ -0,0 +1,16 @@
+#ifndef IDCACHE_H
+#define IDCACHE_H
+
+#include <sys/types.h>
+
+// uid / gid 到名字的进程级缓存：ls -l 这类按文件查属主的地方，同一个 id 只查一次
+// （LDAP / SSSD 下每次查询都是一次网络往返）。查不到的 id 也缓存，名字用数字代替；
+// 查询出错（目录服务超时等）时只临时用数字，下次再查。
+// 环境变量 DESHELL_ID_CACHE_TTL 设为秒数时，过期的条目会重新查询；默认一直有效。
+// 可多线程调用，返回的字符串在进程内一直有效
+const char *id_user_name(uid_t uid);
+const char *id_group_name(gid_t gid);
+// 用户的主目录，查不到返回 NULL
+const char *id_user_home(uid_t uid);
+
+#endif
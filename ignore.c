@@ -0,0 +1,144 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "ignore.h"
+#include "wildcard.h"
+
+typedef struct {
+    char *pattern;
+    int negate;      // "!pattern"：重新包含
+    int dir_only;    // "pattern/"：只匹配目录
+    int anchored;    // 含 '/'：相对规则文件所在目录匹配整条路径，否则只匹配文件名
+} IgnoreRule;
+
+struct IgnoreList {
+    IgnoreList *parent;
+    IgnoreList *next_all;   // IgnoreSet 中的链表
+    size_t base_len;        // 规则文件所在目录的路径长度
+    IgnoreRule *rules;
+    int count, cap;
+};
+
+void ignore_set_init(IgnoreSet *set) {
+    pthread_mutex_init(&set->lock, NULL);
+    set->all = NULL;
+}
+
+void ignore_set_free(IgnoreSet *set) {
+    IgnoreList *l = set->all;
+    while (l) {
+        IgnoreList *next = l->next_all;
+        for (int i = 0; i < l->count; i++) {
+            free(l->rules[i].pattern);
+        }
+        free(l->rules);
+        free(l);
+        l = next;
+    }
+    set->all = NULL;
+    pthread_mutex_destroy(&set->lock);
+}
+
+// 解析一行规则，空行和注释返回 0
+static int parse_rule(char *line, IgnoreRule *rule) {
+    size_t len = strlen(line);
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) len--;
+    // 末尾的空格忽略，除非用 '\' 转义
+    while (len > 0 && line[len - 1] == ' ' && !(len > 1 && line[len - 2] == '\\')) len--;
+    line[len] = '\0';
+    if (len == 0 || line[0] == '#') return 0;
+
+    memset(rule, 0, sizeof(*rule));
+    char *p = line;
+    if (*p == '!') {
+        rule->negate = 1;
+        p++;
+    } else if (p[0] == '\\' && (p[1] == '!' || p[1] == '#')) {
+        p++;
+    }
+    len = strlen(p);
+    if (len > 0 && p[len - 1] == '/') {
+        rule->dir_only = 1;
+        p[--len] = '\0';
+    }
+    if (*p == '/') {
+        rule->anchored = 1;
+        p++;
+    } else if (strchr(p, '/')) {
+        rule->anchored = 1;
+    }
+    if (*p == '\0') return 0;
+    rule->pattern = strdup(p);
+    return rule->pattern != NULL;
+}
+
+static void load_file(IgnoreList **list, IgnoreList *parent, const char *dir, int dirfd,
+                      const char *name) {
+    // 相对遍历时已打开的目录，不再按拼出的路径重新解析
+    int fd = openat(dirfd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    FILE *fp = fdopen(fd, "r");
+    if (!fp) {
+        close(fd);
+        return;
+    }
+
+    char *line = NULL;
+    size_t cap = 0;
+    while (getline(&line, &cap, fp) != -1) {
+        IgnoreRule rule;
+        if (!parse_rule(line, &rule)) continue;
+        if (!*list) {
+            *list = calloc(1, sizeof(IgnoreList));
+            if (!*list) {
+                free(rule.pattern);
+                break;
+            }
+            (*list)->parent = parent;
+            (*list)->base_len = strlen(dir);
+        }
+        IgnoreList *l = *list;
+        if (l->count == l->cap) {
+            l->cap = l->cap ? l->cap * 2 : 16;
+            l->rules = realloc(l->rules, l->cap * sizeof(IgnoreRule));
+        }
+        l->rules[l->count++] = rule;
+    }
+    free(line);
+    fclose(fp);
+}
+
+IgnoreList *ignore_load(IgnoreSet *set, IgnoreList *parent, const char *dir, int dirfd) {
+    IgnoreList *list = NULL;
+    // .ignore 后读，规则冲突时优先
+    load_file(&list, parent, dir, dirfd, ".gitignore");
+    load_file(&list, parent, dir, dirfd, ".ignore");
+    if (!list) return parent;
+
+    pthread_mutex_lock(&set->lock);
+    list->next_all = set->all;
+    set->all = list;
+    pthread_mutex_unlock(&set->lock);
+    return list;
+}
+
+int ignore_match(const IgnoreList *list, const char *path, int is_dir) {
+    const char *slash = strrchr(path, '/');
+    const char *name = slash ? slash + 1 : path;
+    // 由深到浅：越靠近文件的规则表越优先，同一表中后写的规则优先
+    for (const IgnoreList *l = list; l; l = l->parent) {
+        const char *rel = path + l->base_len;
+        if (*rel == '/') rel++;
+        for (int i = l->count - 1; i >= 0; i--) {
+            const IgnoreRule *r = &l->rules[i];
+            if (r->dir_only && !is_dir) continue;
+            if (wildcard_match(r->pattern, r->anchored ? rel : name, WILDCARD_PATHNAME)) {
+                return !r->negate;
+            }
+        }
+    }
+    return 0;
+}
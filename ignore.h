@@ -0,0 +1,24 @@
+#ifndef IGNORE_H
+#define IGNORE_H
+
+#include <pthread.h>
+
+// grep -r 的忽略规则：遍历时读取每个目录下的 .gitignore 和 .ignore，
+// 被忽略的子目录在打开之前就剪掉。规则在每个目录只编译一次，子目录沿父指针继承
+typedef struct IgnoreList IgnoreList;
+
+// 一次遍历中创建的所有规则表，遍历结束后统一释放
+typedef struct IgnoreSet {
+    pthread_mutex_t lock;
+    IgnoreList *all;
+} IgnoreSet;
+
+void ignore_set_init(IgnoreSet *set);
+void ignore_set_free(IgnoreSet *set);
+// 读取目录下的忽略文件：dirfd 是目录已打开的描述符，忽略文件相对它打开；
+// dir 是遍历时拼出的路径，只用作匹配时的前缀。目录里没有忽略文件时直接返回 parent
+IgnoreList *ignore_load(IgnoreSet *set, IgnoreList *parent, const char *dir, int dirfd);
+// path 是遍历时拼出的路径（以各层规则表的目录为前缀），被忽略返回 1
+int ignore_match(const IgnoreList *list, const char *path, int is_dir);
+
+#endif
@@ -5,12 +5,11 @@
 #include <unistd.h>
 #include <string.h>
 #include <dirent.h>
-#include <fnmatch.h>
 #include "builtin.h"
 #include "input.h" 
+#include "wildcard.h"
 
 //#define MAX_INPUT 1024
-#define MAX_ARGS 128
 extern char *history[HISTORY_SIZE];
 extern int history_count;
 
@@ -127,7 +126,7 @@ char *read_input_line() {
             // === 1. 首词 → 补全命令 ===
 
             if (is_first_token && prefix[0] != '$') {
-                const char *builtins[] = {"cd", "ls", "cat", "echo", "alias", "unalias", "grep", "type", "history", "clearhistory", NULL};
+                const char *builtins[] = {"cd", "ls", "cat", "echo", "alias", "unalias", "grep", "type", "history", "clearhistory", "index", "du", "find", "hash", NULL};
                 for (int i = 0; builtins[i]; i++) {
                     if (strncmp(builtins[i], prefix, plen) == 0)
                         matches[match_count++] = (char *)builtins[i];
@@ -273,14 +272,31 @@ char *read_input_line() {
 }
 
 
-#define MAX_ARGS 128
+typedef struct {
+    Arena *arena;
+    char **argv;
+    int argc;
+    int cap;
+} ArgList;
+
+static void arg_push(ArgList *l, char *arg) {
+    if (l->argc + 1 >= l->cap) {
+        int cap = l->cap * 2;
+        char **grown = arena_alloc(l->arena, cap * sizeof(char *));
+        memcpy(grown, l->argv, l->argc * sizeof(char *));
+        l->argv = grown;
+        l->cap = cap;
+    }
+    l->argv[l->argc++] = arg;
+}
 
-char **expand_args(char **args) {
-    static char *new_args[MAX_ARGS];
-    int new_argc = 0;
+// 展开命令里未加引号的通配符，结果在 arena 里，参数个数不限
+char **expand_args(Arena *a, const SimpleCommand *cmd) {
+    ArgList l = {a, NULL, 0, cmd->argc + 2};
+    l.argv = arena_alloc(a, l.cap * sizeof(char *));
 
-    for (int i = 0; args[i] != NULL; i++) {
-        if (strpbrk(args[i], "*?[") != NULL) {
+    for (int i = 0; i < cmd->argc; i++) {
+        if (cmd->glob[i]) {
             // 含通配符，尝试匹配
             DIR *dir = opendir(".");
             if (!dir) continue;
@@ -288,10 +304,9 @@ char **expand_args(char **args) {
             int match_found = 0;
 
             while ((entry = readdir(dir))) {
-                if (fnmatch(args[i], entry->d_name, 0) == 0) {
-                    new_args[new_argc++] = strdup(entry->d_name);
+                if (wildcard_match(cmd->argv[i], entry->d_name, 0)) {
+                    arg_push(&l, arena_strndup(a, entry->d_name, strlen(entry->d_name)));
                     match_found = 1;
-                    if (new_argc >= MAX_ARGS - 1) break;
                 }
             }
 
@@ -299,30 +314,30 @@ char **expand_args(char **args) {
 
             if (!match_found) {
                 // 无匹配时保留原始参数，防止如 cat t*.txt 卡死
-                new_args[new_argc++] = strdup(args[i]);
+                arg_push(&l, cmd->argv[i]);
             }
 
         } else {
-            new_args[new_argc++] = strdup(args[i]);
+            arg_push(&l, cmd->argv[i]);
         }
     }
 
     // 如果是仅输入了 "ls" 或 "ls -l"，补一个 "."
-    if (new_argc > 0 && strcmp(new_args[0], "ls") == 0) {
+    if (l.argc > 0 && strcmp(l.argv[0], "ls") == 0) {
         int has_file_arg = 0;
-        for (int i = 1; i < new_argc; ++i) {
-            if (new_args[i][0] != '-') {
+        for (int i = 1; i < l.argc; ++i) {
+            if (l.argv[i][0] != '-') {
                 has_file_arg = 1;
                 break;
             }
         }
         if (!has_file_arg) {
-            new_args[new_argc++] = strdup(".");
+            arg_push(&l, ".");
         }
     }
 
-    new_args[new_argc] = NULL;
-    return new_args;
+    l.argv[l.argc] = NULL;
+    return l.argv;
 }
 
 
@@ -1,8 +1,10 @@
 #ifndef INPUT_H
 #define INPUT_H
 
+#include "parse.h"
+
 char *read_input_line();
 void filter_and_add_history(const char *cmd);
-char **expand_args(char **args);
+char **expand_args(Arena *a, const SimpleCommand *cmd);
 
 #endif  
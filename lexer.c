@@ -0,0 +1,194 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "lexer.h"
+
+typedef struct {
+    Arena *arena;
+    Token *tokens;
+    int count;
+    int cap;
+} TokenBuf;
+
+static Token *push(TokenBuf *tb, TokenType type) {
+    if (tb->count == tb->cap) {
+        int cap = tb->cap ? tb->cap * 2 : 64;
+        Token *grown = arena_alloc(tb->arena, cap * sizeof(Token));
+        if (tb->count) memcpy(grown, tb->tokens, tb->count * sizeof(Token));
+        tb->tokens = grown;
+        tb->cap = cap;
+    }
+    Token *t = &tb->tokens[tb->count++];
+    t->type = type;
+    t->quoted = 0;
+    t->glob = 0;
+    t->text = NULL;
+    return t;
+}
+
+// 字符分类表：普通字符可以整段直接复制，不必逐个比较
+enum { CH_PLAIN, CH_END, CH_QUOTE, CH_GLOB, CH_DOLLAR };
+
+static const unsigned char char_class[256] = {
+    ['\0'] = CH_END, [' '] = CH_END, ['\t'] = CH_END, ['\n'] = CH_END,
+    ['|'] = CH_END, ['&'] = CH_END, [';'] = CH_END, ['('] = CH_END, [')'] = CH_END,
+    ['<'] = CH_END, ['>'] = CH_END,
+    ['\''] = CH_QUOTE, ['"'] = CH_QUOTE, ['\\'] = CH_QUOTE,
+    ['*'] = CH_GLOB, ['?'] = CH_GLOB, ['['] = CH_GLOB,
+    ['$'] = CH_DOLLAR,
+};
+
+typedef struct {
+    Arena *arena;
+    char *buf;              // 下一个字符写到这里
+    char *limit;            // 缓冲的末尾
+    const char *src_end;    // 整行的结尾，算剩余长度用
+} WordBuf;
+
+// 展开环境变量：$NAME 或 ${NAME}，*p 指向 '$'。不是变量名的 $ 原样保留。
+// 变量值可能比 $NAME 长，剩下的缓冲不够时给当前词和行的剩余部分换一块新的
+static void expand_var(WordBuf *wb, Token *t, const char **p) {
+    const char *s = *p + 1;
+    int braced = *s == '{';
+    if (braced) s++;
+    const char *name = s;
+    if (isalpha((unsigned char)*s) || *s == '_') {
+        while (isalnum((unsigned char)*s) || *s == '_') s++;
+    }
+    if (s == name || (braced && *s != '}')) {
+        *wb->buf++ = *(*p)++;
+        return;
+    }
+    char key[256];
+    size_t len = s - name;
+    if (len >= sizeof(key)) len = sizeof(key) - 1;
+    memcpy(key, name, len);
+    key[len] = '\0';
+    *p = s + braced;
+
+    const char *value = getenv(key);
+    size_t vlen = value ? strlen(value) : 0;
+    size_t rest = wb->src_end - *p + 1;
+    if ((size_t)(wb->limit - wb->buf) < vlen + rest) {
+        // 多留一倍，整段脚本里大量展开时不必每次都换
+        size_t done = wb->buf - t->text;
+        size_t size = done + 2 * (vlen + rest);
+        char *fresh = arena_alloc(wb->arena, size);
+        memcpy(fresh, t->text, done);
+        t->text = fresh;
+        wb->buf = fresh + done;
+        wb->limit = fresh + size;
+    }
+    if (vlen) memcpy(wb->buf, value, vlen);
+    wb->buf += vlen;
+}
+
+int lex_line(Arena *a, const char *src, TokenList *out, const char **error) {
+    TokenBuf tb = {a, NULL, 0, 0};
+    // 去掉引号后词只会变短，每个词之后至少跟一个分隔字符放得下 '\0'，整行的词共用一块缓冲；
+    // 只有变量展开会变长，由 expand_var 按需换缓冲
+    size_t size = strlen(src) + 1;
+    WordBuf wb = {a, arena_alloc(a, size), NULL, src + size - 1};
+    wb.limit = wb.buf + size;
+    const char *p = src;
+    *error = NULL;
+
+    while (1) {
+        while (*p == ' ' || *p == '\t' || (p[0] == '\\' && p[1] == '\n')) p += *p == '\\' ? 2 : 1;
+        char c = *p;
+        if (c == '\0') break;
+        if (c == '#') {
+            while (*p && *p != '\n') p++;
+            continue;
+        }
+        switch (c) {
+        case '\n': push(&tb, TOK_NEWLINE); p++; continue;
+        case ';':  push(&tb, TOK_SEMI); p++; continue;
+        case '(':  push(&tb, TOK_LPAREN); p++; continue;
+        case ')':  push(&tb, TOK_RPAREN); p++; continue;
+        case '<':  push(&tb, TOK_LESS); p++; continue;
+        case '>':  push(&tb, TOK_GREAT); p++; continue;
+        case '|':
+            push(&tb, p[1] == '|' ? TOK_OR : TOK_PIPE);
+            p += p[1] == '|' ? 2 : 1;
+            continue;
+        case '&':
+            push(&tb, p[1] == '&' ? TOK_AND : TOK_AMP);
+            p += p[1] == '&' ? 2 : 1;
+            continue;
+        }
+
+        Token *t = push(&tb, TOK_WORD);
+        t->text = wb.buf;
+        int expanded = 0;
+        while (1) {
+            const char *start = p;
+            while (char_class[(unsigned char)*p] == CH_PLAIN) p++;
+            memcpy(wb.buf, start, p - start);
+            wb.buf += p - start;
+            int cls = char_class[(unsigned char)*p];
+            if (cls == CH_END) break;
+            if (cls == CH_DOLLAR) {
+                expand_var(&wb, t, &p);
+                expanded = 1;
+            } else if (cls == CH_GLOB) {
+                t->glob = 1;
+                *wb.buf++ = *p++;
+            } else if (*p == '\'') {
+                const char *end = strchr(p + 1, '\'');
+                if (!end) {
+                    *error = "缺少与 ' 配对的引号";
+                    return -1;
+                }
+                memcpy(wb.buf, p + 1, end - p - 1);
+                wb.buf += end - p - 1;
+                p = end + 1;
+                t->quoted = 1;
+            } else if (*p == '"') {
+                p++;
+                while (*p != '"') {
+                    if (*p == '\0') {
+                        *error = "缺少与 \" 配对的引号";
+                        return -1;
+                    }
+                    // 双引号里照样展开变量（单引号里不展开）
+                    if (*p == '$') {
+                        expand_var(&wb, t, &p);
+                        continue;
+                    }
+                    // 双引号里只有 \" \\ \$ \` 和续行是转义，其余反斜杠原样保留
+                    if (*p == '\\' && (p[1] == '"' || p[1] == '\\' || p[1] == '$' || p[1] == '`')) {
+                        p++;
+                    } else if (*p == '\\' && p[1] == '\n') {
+                        p += 2;
+                        continue;
+                    }
+                    *wb.buf++ = *p++;
+                }
+                p++;
+                t->quoted = 1;
+            } else if (*p == '\\') {
+                t->quoted = 1;
+                if (p[1] == '\0') {
+                    p++;
+                } else if (p[1] == '\n') {
+                    p += 2;
+                } else {
+                    *wb.buf++ = p[1];
+                    p += 2;
+                }
+            }
+        }
+        // 没加引号、展开后为空的词（如未设置的 $X）整个去掉
+        if (expanded && !t->quoted && wb.buf == t->text) {
+            tb.count--;
+            continue;
+        }
+        *wb.buf++ = '\0';
+    }
+
+    push(&tb, TOK_END);
+    out->tokens = tb.tokens;
+    out->count = tb.count;
+    return 0;
+}
@@ -0,0 +1,38 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include "arena.h"
+
+// 命令行的词法分析：一遍扫描同时处理空白、引号、转义、$VAR 展开、注释和运算符，
+// 词的内容直接写成去掉引号后的样子，不再由 strtok 和各个命令自己剥引号
+typedef enum {
+    TOK_WORD,
+    TOK_PIPE,       // |
+    TOK_OR,         // ||
+    TOK_AMP,        // &
+    TOK_AND,        // &&
+    TOK_SEMI,       // ;
+    TOK_NEWLINE,    // 换行，和 ; 一样分隔命令
+    TOK_LPAREN,     // (
+    TOK_RPAREN,     // )
+    TOK_LESS,       // <
+    TOK_GREAT,      // >
+    TOK_END
+} TokenType;
+
+typedef struct {
+    TokenType type;
+    unsigned char quoted;   // 词里有引号或转义（不做别名展开）
+    unsigned char glob;     // 词里有未加引号的 * ? [
+    char *text;             // TOK_WORD 的内容
+} Token;
+
+typedef struct {
+    Token *tokens;          // 以 TOK_END 结尾
+    int count;
+} TokenList;
+
+// 把 src 切成词和运算符，结果分配在 arena 里；引号不配对时返回 -1 并置 *error
+int lex_line(Arena *a, const char *src, TokenList *out, const char **error);
+
+#endif
@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "builtin.h"
+#include "dirread.h"
+#include "idcache.h"
+#include "statbatch.h"
+
+void print_long_format(FILE *out, const struct stat *st, const char *name) {
+    fprintf(out, "%c%c%c%c%c%c%c%c%c%c %3ld %-8s %-8s %8ld %s\n",
+        S_ISDIR(st->st_mode) ? 'd' : S_ISLNK(st->st_mode) ? 'l' : '-',
+        st->st_mode & S_IRUSR ? 'r' : '-',
+        st->st_mode & S_IWUSR ? 'w' : '-',
+        st->st_mode & S_IXUSR ? 'x' : '-',
+        st->st_mode & S_IRGRP ? 'r' : '-',
+        st->st_mode & S_IWGRP ? 'w' : '-',
+        st->st_mode & S_IXGRP ? 'x' : '-',
+        st->st_mode & S_IROTH ? 'r' : '-',
+        st->st_mode & S_IWOTH ? 'w' : '-',
+        st->st_mode & S_IXOTH ? 'x' : '-',
+        (long)st->st_nlink,
+        id_user_name(st->st_uid),
+        id_group_name(st->st_gid),
+        (long)st->st_size,
+        name
+    );
+}
+
+#define LS_BATCH 4096
+
+// 一批条目的元数据一起取，按目录顺序输出
+static void print_batch(StatBatch *sb, int dirfd, char **names, int n) {
+    struct stat *st = malloc(n * sizeof(struct stat));
+    int *errs = malloc(n * sizeof(int));
+    if (st && errs) {
+        stat_batch_run(sb, dirfd, names, n, 0, st, errs);
+        for (int i = 0; i < n; i++) {
+            if (errs[i] == 0) print_long_format(stdout, &st[i], names[i]);
+        }
+    }
+    for (int i = 0; i < n; i++) free(names[i]);
+    free(st);
+    free(errs);
+}
+
+// 列出一个目录：短格式只用目录项里的名字，一个 stat 都不做；
+// 长格式对目录描述符批量取元数据，不再拼路径
+static int list_dir(DirReader *dir, const char *path, int long_format, StatBatch *sb) {
+    char *names[LS_BATCH];
+    int n = 0;
+    const DirEntry *entry;
+    while ((entry = dir_next(dir)) != NULL) {
+        if (!long_format) {
+            fputs(entry->name, stdout);
+            fputs("  ", stdout);
+            continue;
+        }
+        // 目录项所在的缓冲区下次读取时会被覆盖，名字要复制出来
+        names[n] = strdup(entry->name);
+        if (names[n] && ++n == LS_BATCH) {
+            print_batch(sb, dir_fd(dir), names, n);
+            n = 0;
+        }
+    }
+    if (n > 0) print_batch(sb, dir_fd(dir), names, n);
+    if (dir_error(dir)) {
+        errno = dir_error(dir);
+        perror(path);
+        return 1;
+    }
+    return 0;
+}
+
+int my_ls(char **args) {
+    int long_format = 0;
+    int status = 0;
+    int start = 1;
+
+    // 检查是否有 -l 参数
+    for (int i = 1; args[i]; i++) {
+        if (strcmp(args[i], "-l") == 0) {
+            long_format = 1;
+            start++;
+        }
+    }
+
+    if (!args[start]) {
+        args[start] = ".";
+        args[start + 1] = NULL;
+    }
+
+    StatBatch *sb = long_format ? stat_batch_new() : NULL;
+    for (int i = start; args[i]; i++) {
+        // 先按目录打开，打不开且不是目录时再当普通文件处理，省掉一次 stat
+        DirReader *dir = dir_open(AT_FDCWD, args[i]);
+        if (dir) {
+            status |= list_dir(dir, args[i], long_format, sb);
+            dir_close(dir);
+            continue;
+        }
+        if (errno != ENOTDIR) {
+            perror(args[i]);
+            status = 1;
+            continue;
+        }
+
+        // 普通文件直接打印
+        if (!long_format) {
+            printf("%s  ", args[i]);
+        } else {
+            struct stat st;
+            if (stat(args[i], &st) != 0) {
+                perror(args[i]);
+                status = 1;
+                continue;
+            }
+            print_long_format(stdout, &st, args[i]);
+        }
+    }
+    stat_batch_free(sb);
+    if (!long_format) printf("\n");
+    return status;
+}
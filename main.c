@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,9 +12,9 @@
 #include <ctype.h>
 #include "builtin.h"
 #include "input.h"
+#include "spawn.h"
+#include "eval.h"
 
-#define MAX_LINE 1024
-#define MAX_ARGS 64
 #define MAX_COMMAND_LENGTH 2048
 
 void handle_sigint(int sig) {
@@ -22,77 +23,6 @@ void handle_sigint(int sig) {
     fflush(stdout);
 }
 
-void parse_and_expand_alias(char *line, char **args) {
-    static char reconstructed_line[MAX_LINE];
-    memset(reconstructed_line, 0, sizeof(reconstructed_line));
-
-    char original_line[MAX_LINE];
-    strncpy(original_line, line, sizeof(original_line) - 1);
-    original_line[sizeof(original_line) - 1] = '\0';
-
-    char *first_token = strtok(original_line, " \t\n");
-    if (!first_token) {
-        args[0] = NULL;
-        return;
-    }
-
-    const char *alias_cmd = resolve_alias(first_token);
-    if (alias_cmd) {
-        strncat(reconstructed_line, alias_cmd, sizeof(reconstructed_line) - 1);
-        char *rest = line + (first_token - original_line) + strlen(first_token);
-        strncat(reconstructed_line, rest, sizeof(reconstructed_line) - strlen(reconstructed_line) - 1);
-    } else {
-        strncpy(reconstructed_line, line, sizeof(reconstructed_line) - 1);
-    }
-
-    int i = 0;
-    args[i] = strtok(reconstructed_line, " \t\n");
-    while (args[i] != NULL && i < MAX_ARGS - 1) {
-        args[++i] = strtok(NULL, " \t\n");
-    }
-}
-
-// 新增：重定向解析函数
-void parse_redirection(char **args, char **input_file, char **output_file) {
-    *input_file = NULL;
-    *output_file = NULL;
-    
-    int i = 0;
-    while (args[i] != NULL) {
-        if (strcmp(args[i], "<") == 0) {
-            if (args[i+1] == NULL) {
-                fprintf(stderr, "语法错误: 缺少输入文件\n");
-            } else {
-                *input_file = args[i+1];
-                args[i] = NULL; // 移除重定向符号
-                args[i+1] = NULL; // 移除文件名
-            }
-        }
-        else if (strcmp(args[i], ">") == 0) {
-            if (args[i+1] == NULL) {
-                fprintf(stderr, "语法错误: 缺少输出文件\n");
-            } else {
-                *output_file = args[i+1];
-                args[i] = NULL;
-                args[i+1] = NULL;
-            }
-        }
-        i++;
-    }
-}
-
-// 新增：压缩参数数组（移除NULL）
-void compress_args(char **args) {
-    int i = 0, j = 0;
-    while (args[i]) {
-        if (args[i] != NULL) {
-            args[j++] = args[i];
-        }
-        i++;
-    }
-    args[j] = NULL;
-}
-
 int is_valid_command(char *line) {
     if (line == NULL || strlen(line) == 0) return 0;
     for (char *p = line; *p; p++) {
@@ -138,47 +68,52 @@ int login_shell() {
         return 0;
     }
 }
-// 新增管道执行函数
-void execute_pipeline(char **args, int pipe_count, int background, int is_builtin_cmd, const char *raw_line) {
-    // 分割命令
-    // 创建命令数组（二维数组），注意：不能初始化，所以手动置NULL
-    char *commands[pipe_count + 1][MAX_ARGS];
-    // 初始化数组为NULL
-    for (int i = 0; i < pipe_count + 1; i++) {
-        for (int j = 0; j < MAX_ARGS; j++) {
-            commands[i][j] = NULL;
-        }
-    }
-    int cmd_index = 0, arg_index = 0;
-    
-    for (int i = 0; args[i]; i++) {
-        if (strcmp(args[i], "|") == 0) {
-            commands[cmd_index][arg_index] = NULL;
-            cmd_index++;
-            arg_index = 0;
-        } else {
-            commands[cmd_index][arg_index++] = args[i];
-        }
-    }
-    commands[cmd_index][arg_index] = NULL;
-    int cmd_total = cmd_index + 1;
-    
-    // 创建管道
+// 新增管道执行函数：返回最后一段命令的退出状态
+int execute_pipeline(Arena *a, SimpleCommand *cmds, int cmd_total, int background) {
+    int pipe_count = cmd_total - 1;
+
+    // 创建管道：带 O_CLOEXEC，外部命令由 file action 接到 0 / 1，其余端不会漏进子进程
     int pipes[pipe_count][2];
     for (int i = 0; i < pipe_count; i++) {
-        if (pipe(pipes[i]) < 0) {
+        if (pipe2(pipes[i], O_CLOEXEC) < 0) {
             perror("pipe failed");
-            return;
+            return 1;
         }
     }
     
+    fflush(stdout);
     pid_t pids[cmd_total];
+    int launch_status = 127;   // 最后一段没能启动时的退出状态
     for (int i = 0; i < cmd_total; i++) {
+        pids[i] = -1;
+        char **args = expand_args(a, &cmds[i]);
+
+        if (!is_builtin(args[0])) {
+            // 外部命令不 fork：重定向文件在这里打开，连同管道交给 posix_spawn
+            SpawnIo io = {i > 0 ? pipes[i-1][0] : -1, i < cmd_total - 1 ? pipes[i][1] : -1};
+            int in_fd = -1, out_fd = -1;
+            if (cmds[i].input_file && (in_fd = spawn_open_input(cmds[i].input_file)) < 0) continue;
+            if (cmds[i].output_file && (out_fd = spawn_open_output(cmds[i].output_file)) < 0) {
+                if (in_fd >= 0) close(in_fd);
+                continue;
+            }
+            if (in_fd >= 0) io.stdin_fd = in_fd;
+            if (out_fd >= 0) io.stdout_fd = out_fd;
+            pids[i] = spawn_command(args, &io);
+            if (pids[i] < 0) {
+                int s = spawn_report_error(args[0]);
+                if (i == cmd_total - 1) launch_status = s;
+            }
+            if (in_fd >= 0) close(in_fd);
+            if (out_fd >= 0) close(out_fd);
+            continue;
+        }
+
         pids[i] = fork();
         
         if (pids[i] < 0) {
             perror("fork failed");
-            return;
+            return 1;
         } else if (pids[i] == 0) {
             // 子进程 - 设置管道连接
             if (i > 0) {
@@ -194,45 +129,10 @@ void execute_pipeline(char **args, int pipe_count, int background, int is_builti
                 close(pipes[j][1]);
             }
             
-            // 处理重定向
-            char *input_file = NULL;
-            char *output_file = NULL;
-            parse_redirection(commands[i], &input_file, &output_file);
-            compress_args(commands[i]);
-            
-            if (input_file) {
-                int fd = open(input_file, O_RDONLY);
-                if (fd < 0) {
-                    perror("打开输入文件失败");
-                    exit(EXIT_FAILURE);
-                }
-                dup2(fd, STDIN_FILENO);
-                close(fd);
-            }
-            
-            if (output_file) {
-                int fd = open(output_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
-                if (fd < 0) {
-                    perror("创建输出文件失败");
-                    exit(EXIT_FAILURE);
-                }
-                dup2(fd, STDOUT_FILENO);
-                close(fd);
-            }
-            
-            // 执行命令
-            if (is_builtin(commands[i][0]) && 
-                (strcmp(commands[i][0], "cd") == 0 || 
-                 strcmp(commands[i][0], "alias") == 0 || 
-                 strcmp(commands[i][0], "unalias") == 0)) {
-                // 管道中的特殊内置命令需要特殊处理
-                run_builtin(commands[i], raw_line);
-                exit(0);
-            } else {
-                execvp(commands[i][0], commands[i]);
-                perror(commands[i][0]);
-                exit(EXIT_FAILURE);
-            }
+            // 内置命令直接在子进程里执行，读写的就是管道，不再 exec 同名的系统命令；
+            // 退出状态和单独执行时一样取自 builtin_status
+            run_builtin(args, cmds[i].input_file, cmds[i].output_file);
+            exit(builtin_status);
         }
     }
     
@@ -242,100 +142,98 @@ void execute_pipeline(char **args, int pipe_count, int background, int is_builti
         close(pipes[i][1]);
     }
     
-    if (!background) {
-        for (int i = 0; i < cmd_total; i++) {
-            waitpid(pids[i], NULL, 0);
-        }
-    } else {
+    if (background) {
         fprintf(stderr, "[Pipeline %d] running in background\n", getpid());
+        return 0;
     }
+    int status = launch_status;
+    for (int i = 0; i < cmd_total; i++) {
+        if (pids[i] <= 0) continue;
+        int s = wait_status(pids[i]);
+        if (i == cmd_total - 1) status = s;
+    }
+    return status;
 }
 
-// 新增函数：判断是否为逻辑组合或命令组
-int is_group_or_logic(char *line) {
-    return (strchr(line, '(') || strstr(line, "&&") || strstr(line, "||"));
-}
-
-// 新增函数：处理命令组合与命令组
-int execute_group_logic(char *line) {
-    while (*line == ' ') line++;
-    if (*line == '\0') return 0;
 
-    int background = 0;
-    char *amp = strrchr(line, '&');
-    if (amp && *(amp + 1) == '\0') {
-        background = 1;
-        *amp = '\0';
+// 单个外部命令：重定向文件由 shell 打开，posix_spawn 启动，不 fork 整个 shell
+static int run_external(char **args, const SimpleCommand *cmd, int background) {
+    SpawnIo io = {-1, -1};
+    if (cmd->input_file && (io.stdin_fd = spawn_open_input(cmd->input_file)) < 0) return 1;
+    if (cmd->output_file && (io.stdout_fd = spawn_open_output(cmd->output_file)) < 0) {
+        if (io.stdin_fd >= 0) close(io.stdin_fd);
+        return 1;
+    }
+    if (background) printf("\n");
+    fflush(stdout);
+    pid_t pid = spawn_command(args, &io);
+    if (io.stdin_fd >= 0) close(io.stdin_fd);
+    if (io.stdout_fd >= 0) close(io.stdout_fd);
+    if (pid < 0) return spawn_report_error(args[0]);
+
+    if (background) {
+        fprintf(stderr, "[PID %d] running in background\n", pid);
+        fflush(stderr);
+        return 0;
     }
+    return wait_status(pid);
+}
 
-    // 括号包裹优先
-    if (*line == '(') {
-        char *end = strrchr(line, ')');
-        if (end) {
-            *end = '\0';
-            char *inner = line + 1;
-            while (*inner == ' ' || *inner == '\t') inner++;
-            if (background) {
-                if (fork() == 0) exit(system(inner));
-                return 0;
-            } else {
-                return system(inner);
-            }
-        }
+// 一条简单命令或管道：通配符展开后按内置 / 外部命令执行，返回退出状态。
+// 别名和重定向在解析时已经处理好；单独输入的命令和 ; && || ( ) 里的每条命令都走这里
+int execute_simple(Arena *a, SimpleCommand *cmds, int ncmds, int background) {
+    if (ncmds > 1) {
+        return execute_pipeline(a, cmds, ncmds, background);
     }
 
-    // 多命令串联 ; （一次性执行所有子句）
-    if (strchr(line, ';')) {
-        char *saveptr;
-        char *segment = strtok_r(line, ";", &saveptr);
-        while (segment) {
-            while (*segment == ' ' || *segment == '\t') segment++;
-            if (*segment) {
-                if (background) {
-                    if (fork() == 0) exit(system(segment));
-                } else {
-                    system(segment);
-                }
-            }
-            segment = strtok_r(NULL, ";", &saveptr);
-        }
+    SimpleCommand *cmd = &cmds[0];
+    char **args = expand_args(a, cmd);
+    if (strcmp(args[0], "exit") == 0) {
+        shell_exit_requested = 1;
         return 0;
     }
 
-    // 逻辑组合
-    char *and = strstr(line, "&&");
-    char *or = strstr(line, "||");
-    if (and && (!or || and < or)) {
-        *and = '\0';
-        int status = execute_group_logic(line);
-        return (status == 0) ? execute_group_logic(and + 2) : status;
-    } else if (or) {
-        *or = '\0';
-        int status = execute_group_logic(line);
-        return (status != 0) ? execute_group_logic(or + 2) : 0;
+    if (!is_builtin(args[0])) {
+        return run_external(args, cmd, background);
     }
 
-    // 最终 fallback 执行单条命令
-    int pid = fork();
-    if (pid == 0) {
-        execlp("/bin/sh", "sh", "-c", line, NULL);
-        perror("exec");
-        exit(127);
-    } else if (!background) {
-        int status;
-        waitpid(pid, &status, 0);
-        return WEXITSTATUS(status);
-    } else {
-        printf("[PID %d] running in background\n", pid);
+    // cd, alias, unalias, history, hash 等应在主进程运行
+    if (strcmp(args[0], "cd") == 0 ||
+        strcmp(args[0], "alias") == 0 ||
+        strcmp(args[0], "unalias") == 0 ||
+        strcmp(args[0], "history") == 0 ||
+        strcmp(args[0], "clearhistory") == 0 ||
+        strcmp(args[0], "hash") == 0) {
+        run_builtin(args, cmd->input_file, cmd->output_file);
+        return builtin_status;
+    }
+
+    // 其余内置命令 fork 后执行；先清空输出缓冲，免得子进程把回显的换行写进重定向的文件
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork failed");
+        return 1;
+    } else if(pid == 0) {
+        if (background) {
+            printf("\n");
+            fflush(stderr);
+        }
+        // 重定向由 run_builtin 处理
+        run_builtin(args, cmd->input_file, cmd->output_file);
+        exit(builtin_status);
+    }
+    if (background) {
+        //usleep(1000);
+        fprintf(stderr, "[PID %d] running in background\n", pid);
+        fflush(stderr);
         return 0;
     }
+    return wait_status(pid);
 }
 
-
-
 int main() {
     char *line;
-    char *args[MAX_ARGS];
     char command_buffer[MAX_COMMAND_LENGTH];
     char temp_line[MAX_COMMAND_LENGTH];
 
@@ -388,127 +286,13 @@ int main() {
             continue;
         }
 
-        char *line_copy = strdup(line);
-        if (strchr(line,";")||strstr(line,"&&")||strstr(line,"||")||line[0]=='(') {
-            execute_group_logic(line);
-            free(line);
-            free(line_copy);
-            continue;
-        }
-        parse_and_expand_alias(line, args);
-        if (args[0] == NULL) {
-            free(line);
-            free(line_copy);
-            continue;
-        }
-
-        filter_and_add_history(line_copy);
-        char **expanded = expand_args(args);
-        memcpy(args,expanded,sizeof(char *) * MAX_ARGS);
-        if (strcmp(args[0], "exit") == 0) {
-            free(line);
-            free(line_copy);
-            break;
-        }
-
-        int background = 0;
-        int i = 0;
-        while (args[i]) i++;
-        if (i > 0 && strcmp(args[i - 1], "&") == 0) {
-            background = 1;
-            args[i - 1] = NULL;
-        }
-
-        int is_builtin_cmd = is_builtin(args[0]);
-        if (is_builtin_cmd) {
-            // cd, alias, unalias, history 等应在主进程运行
-            if (strcmp(args[0], "cd") == 0 ||
-                strcmp(args[0], "alias") == 0 ||
-                strcmp(args[0], "unalias") == 0 ||
-                strcmp(args[0], "history") == 0 ||
-                strcmp(args[0], "clearhistory") == 0) {
-                run_builtin(args, line_copy);
-                free(line);
-                free(line_copy);
-                continue;
-            }
-        }
-
-        // ============= 修改开始 =============
-        // 检查是否有管道
-        int pipe_count = 0;
-        for (int i = 0; args[i]; i++) {
-            if (strcmp(args[i], "|") == 0) pipe_count++;
-        }
-
-        if (pipe_count > 0) {
-            execute_pipeline(args, pipe_count, background, is_builtin_cmd, line_copy);
-        } else {
-            // 没有管道时执行单个命令
-            pid_t pid = fork();
-            if (pid < 0) {
-                perror("fork failed");
-            } else if(pid == 0) {
-                // 子进程处理重定向
-                    if (background) {
-                        //usleep(1000);
-                        printf("\n");
-                        fflush(stderr);
-                    }
-                char *input_file = NULL;
-                char *output_file = NULL;
-                parse_redirection(args, &input_file, &output_file);
-                compress_args(args);
-                
-                if (input_file) {
-                    int fd = open(input_file, O_RDONLY);
-                    if (fd < 0) {
-                        perror("打开输入文件失败");
-                        exit(EXIT_FAILURE);
-                    }
-                    dup2(fd, STDIN_FILENO);
-                    close(fd);
-                }
-                
-                if (output_file) {
-                    int fd = open(output_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
-                    if (fd < 0) {
-                        perror("创建输出文件失败");
-                        exit(EXIT_FAILURE);
-                    }
-                    dup2(fd, STDOUT_FILENO);
-                    close(fd);
-                }
-                
-                // 执行命令
-                if (is_builtin_cmd) {
-                    run_builtin(args, line_copy);
-                } else {
-                    execvp(args[0], args);
-                }
-                exit(1);
-            } else {
-                if (background) {
-                    //usleep(1000);
-                    fprintf(stderr, "[PID %d] running in background\n", pid);
-                    fflush(stderr);
-                } else {
-                    int status;
-                    waitpid(pid, &status, 0);
-                    if (!is_builtin_cmd && WIFEXITED(status) && WEXITSTATUS(status) != 0) {
-                        fprintf(stderr, "Unknown command: %s\n", args[0]);
-                    }
-                }
-            }
-        }
-        // ============= 修改结束 =============
-
+        // ; && || ( ) & 都由 eval_line 解析成命令树求值，简单命令也是只有一个叶子的树
+        filter_and_add_history(line);
+        eval_line(line);
         free(line);
-        free(line_copy);
+        if (shell_exit_requested) break;
     }
 
     save_history_to_file();
     return 0;
 }
-
-
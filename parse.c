@@ -0,0 +1,219 @@
+#include <string.h>
+#include "parse.h"
+#include "lexer.h"
+
+typedef struct {
+    Arena *arena;
+    Token *tokens;          // 整行的词法单元
+    int pos;
+    Token *alias;           // 正在读的别名内容，读完再回到整行
+    int alias_pos;
+    int alias_count;
+    AliasLookup aliases;
+    const char *error;      // 第一处语法错误
+} Parser;
+
+static Token *peek(Parser *ps) {
+    if (ps->alias_pos < ps->alias_count) return &ps->alias[ps->alias_pos];
+    return &ps->tokens[ps->pos];
+}
+
+static void advance(Parser *ps) {
+    if (ps->alias_pos < ps->alias_count) {
+        ps->alias_pos++;
+    } else if (ps->tokens[ps->pos].type != TOK_END) {
+        ps->pos++;
+    }
+}
+
+static void skip_newlines(Parser *ps) {
+    while (peek(ps)->type == TOK_NEWLINE) advance(ps);
+}
+
+static void syntax_error(Parser *ps, const char *msg) {
+    if (!ps->error) ps->error = msg;
+}
+
+static Node *new_node(Parser *ps, NodeType type, Node *left, Node *right) {
+    Node *n = arena_alloc(ps->arena, sizeof(Node));
+    memset(n, 0, sizeof(Node));
+    n->type = type;
+    n->left = left;
+    n->right = right;
+    return n;
+}
+
+// 命令开头的词是别名时，把别名内容切词后放到整行前面先读；别名里的词不再展开
+static void expand_alias(Parser *ps) {
+    Token *t = peek(ps);
+    if (!ps->aliases || ps->alias_pos < ps->alias_count || t->type != TOK_WORD || t->quoted) return;
+    const char *value = ps->aliases(t->text);
+    if (!value) return;
+
+    TokenList list;
+    const char *error;
+    if (lex_line(ps->arena, value, &list, &error) < 0) {
+        syntax_error(ps, error);
+        return;
+    }
+    advance(ps);
+    ps->alias = list.tokens;
+    ps->alias_pos = 0;
+    ps->alias_count = list.count - 1;   // 不要别名末尾的 TOK_END
+}
+
+static char *parse_redirect_target(Parser *ps, TokenType op) {
+    advance(ps);
+    Token *t = peek(ps);
+    if (t->type != TOK_WORD) {
+        syntax_error(ps, op == TOK_LESS ? "缺少输入文件" : "缺少输出文件");
+        return NULL;
+    }
+    advance(ps);
+    return t->text;
+}
+
+// 简单命令：词和 < > 重定向，碰到其它运算符结束
+static void parse_simple(Parser *ps, SimpleCommand *cmd) {
+    memset(cmd, 0, sizeof(*cmd));
+    expand_alias(ps);
+    int cap = 0;
+    while (!ps->error) {
+        Token *t = peek(ps);
+        if (t->type == TOK_LESS || t->type == TOK_GREAT) {
+            char *file = parse_redirect_target(ps, t->type);
+            if (t->type == TOK_LESS) {
+                cmd->input_file = file;
+            } else {
+                cmd->output_file = file;
+            }
+            continue;
+        }
+        if (t->type != TOK_WORD) break;
+        if (cmd->argc + 1 >= cap) {
+            int new_cap = cap ? cap * 2 : 8;
+            char **argv = arena_alloc(ps->arena, new_cap * sizeof(char *));
+            unsigned char *glob = arena_alloc(ps->arena, new_cap);
+            if (cmd->argc) {
+                memcpy(argv, cmd->argv, cmd->argc * sizeof(char *));
+                memcpy(glob, cmd->glob, cmd->argc);
+            }
+            cmd->argv = argv;
+            cmd->glob = glob;
+            cap = new_cap;
+        }
+        cmd->glob[cmd->argc] = t->glob;
+        cmd->argv[cmd->argc++] = t->text;
+        advance(ps);
+    }
+    if (ps->error) return;
+    if (cmd->argc == 0) {
+        syntax_error(ps, peek(ps)->type == TOK_END ? "运算符后缺少命令" : "运算符前缺少命令");
+        return;
+    }
+    cmd->argv[cmd->argc] = NULL;
+}
+
+static Node *parse_list(Parser *ps, int in_group);
+
+static Node *parse_subshell(Parser *ps) {
+    advance(ps);
+    Node *n = new_node(ps, NODE_SUBSHELL, parse_list(ps, 1), NULL);
+    if (ps->error) return n;
+    if (peek(ps)->type != TOK_RPAREN) {
+        syntax_error(ps, "缺少 )");
+        return n;
+    }
+    if (!n->left) {
+        syntax_error(ps, "( ) 中缺少命令");
+        return n;
+    }
+    advance(ps);
+
+    while (!ps->error) {
+        Token *t = peek(ps);
+        if (t->type == TOK_LESS) {
+            n->input_file = parse_redirect_target(ps, TOK_LESS);
+        } else if (t->type == TOK_GREAT) {
+            n->output_file = parse_redirect_target(ps, TOK_GREAT);
+        } else {
+            break;
+        }
+    }
+    if (peek(ps)->type == TOK_PIPE) {
+        syntax_error(ps, "( ) 不能接入管道");
+    } else if (peek(ps)->type == TOK_WORD || peek(ps)->type == TOK_LPAREN) {
+        syntax_error(ps, ") 后只能跟运算符或重定向");
+    }
+    return n;
+}
+
+// 以 | 相连的简单命令，或一个 ( ) 子 shell
+static Node *parse_pipeline(Parser *ps) {
+    if (peek(ps)->type == TOK_LPAREN) return parse_subshell(ps);
+
+    int cap = 4;
+    Node *n = new_node(ps, NODE_PIPELINE, NULL, NULL);
+    n->cmds = arena_alloc(ps->arena, cap * sizeof(SimpleCommand));
+    while (1) {
+        if (n->ncmds == cap) {
+            SimpleCommand *grown = arena_alloc(ps->arena, cap * 2 * sizeof(SimpleCommand));
+            memcpy(grown, n->cmds, cap * sizeof(SimpleCommand));
+            n->cmds = grown;
+            cap *= 2;
+        }
+        parse_simple(ps, &n->cmds[n->ncmds++]);
+        if (ps->error || peek(ps)->type != TOK_PIPE) break;
+        advance(ps);
+        skip_newlines(ps);
+    }
+    if (!ps->error && peek(ps)->type == TOK_LPAREN) syntax_error(ps, "意外的 (");
+    return n;
+}
+
+// && 和 || 同级、左结合
+static Node *parse_and_or(Parser *ps) {
+    Node *left = parse_pipeline(ps);
+    while (!ps->error) {
+        TokenType type = peek(ps)->type;
+        if (type != TOK_AND && type != TOK_OR) break;
+        advance(ps);
+        skip_newlines(ps);
+        left = new_node(ps, type == TOK_AND ? NODE_AND : NODE_OR, left, parse_pipeline(ps));
+    }
+    return left;
+}
+
+// 以 ; & 或换行分隔的列表，& 把它前面的一段放到后台；in_group 时遇到 ) 结束
+static Node *parse_list(Parser *ps, int in_group) {
+    Node *list = NULL;
+    while (!ps->error) {
+        skip_newlines(ps);
+        TokenType type = peek(ps)->type;
+        if (type == TOK_END || (in_group && type == TOK_RPAREN)) break;
+        Node *item = parse_and_or(ps);
+        if (ps->error) break;
+
+        type = peek(ps)->type;
+        if (type == TOK_AMP) {
+            item = new_node(ps, NODE_BG, item, NULL);
+            advance(ps);
+        } else if (type == TOK_SEMI || type == TOK_NEWLINE) {
+            advance(ps);
+        } else if (type == TOK_RPAREN && !in_group) {
+            syntax_error(ps, "多余的 )");
+        }
+        list = list ? new_node(ps, NODE_SEQ, list, item) : item;
+    }
+    return list;
+}
+
+Node *parse_line(Arena *a, const char *src, AliasLookup aliases, const char **error) {
+    TokenList list;
+    if (lex_line(a, src, &list, error) < 0) return NULL;
+
+    Parser ps = {a, list.tokens, 0, NULL, 0, 0, aliases, NULL};
+    Node *root = parse_list(&ps, 0);
+    *error = ps.error;
+    return ps.error ? NULL : root;
+}
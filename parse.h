@@ -0,0 +1,41 @@
+#ifndef PARSE_H
+#define PARSE_H
+
+#include "arena.h"
+
+// 命令行的语法树：由 lexer.h 的词法单元一次构造，节点、参数数组和字符串全部在 arena 里，
+// 参数个数没有上限。简单命令的重定向在解析时就拆出来，argv 里只剩真正的参数
+typedef struct {
+    char **argv;            // 以 NULL 结尾
+    unsigned char *glob;    // glob[i] 非 0 表示 argv[i] 含未加引号的通配符，执行前要展开
+    int argc;
+    char *input_file;       // <
+    char *output_file;      // >
+} SimpleCommand;
+
+typedef enum {
+    NODE_PIPELINE,   // 一条或以 | 相连的多条简单命令
+    NODE_SUBSHELL,   // ( 列表 )
+    NODE_AND,        // 左 && 右
+    NODE_OR,         // 左 || 右
+    NODE_SEQ,        // 左 ; 右
+    NODE_BG          // 左 &
+} NodeType;
+
+typedef struct Node {
+    NodeType type;
+    SimpleCommand *cmds;    // NODE_PIPELINE 的各段
+    int ncmds;
+    char *input_file;       // NODE_SUBSHELL 的重定向
+    char *output_file;
+    struct Node *left, *right;
+} Node;
+
+// 别名查找：返回别名的内容，不是别名返回 NULL
+typedef const char *(*AliasLookup)(const char *name);
+
+// 解析一整行（或多行脚本）。每条简单命令的第一个词若是别名，就把别名内容切词后接进来（只展开一层）。
+// 空行返回 NULL 且 *error 为 NULL；语法错误返回 NULL 并置 *error
+Node *parse_line(Arena *a, const char *src, AliasLookup aliases, const char **error);
+
+#endif
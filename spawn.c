@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include "spawn.h"
+#include "cmdhash.h"
+
+extern char **environ;
+
+// 没有 #! 行的可执行脚本：execvp 会交给 /bin/sh 执行，posix_spawn 只返回 ENOEXEC，这里照 execvp 补上
+static int spawn_script(pid_t *pid, const char *path, char **argv,
+                        const posix_spawn_file_actions_t *actions, const posix_spawnattr_t *attr) {
+    int argc = 0;
+    while (argv[argc]) argc++;
+    char **sh_argv = malloc((argc + 2) * sizeof(char *));
+    if (!sh_argv) return ENOMEM;
+    sh_argv[0] = "sh";
+    sh_argv[1] = (char *)path;
+    memcpy(sh_argv + 2, argv + 1, argc * sizeof(char *));   // 含结尾的 NULL
+    int err = posix_spawn(pid, "/bin/sh", actions, attr, sh_argv, environ);
+    free(sh_argv);
+    return err;
+}
+
+pid_t spawn_command(char **argv, const SpawnIo *io) {
+    posix_spawn_file_actions_t actions;
+    if (posix_spawn_file_actions_init(&actions) != 0) return -1;
+    // 描述符恰好已是 0 / 1 时 glibc 的 adddup2 会清掉它的 O_CLOEXEC，同样适用
+    if (io && io->stdin_fd >= 0) {
+        posix_spawn_file_actions_adddup2(&actions, io->stdin_fd, STDIN_FILENO);
+    }
+    if (io && io->stdout_fd >= 0) {
+        posix_spawn_file_actions_adddup2(&actions, io->stdout_fd, STDOUT_FILENO);
+    }
+
+    // shell 自己捕获的 SIGINT 在 exec 时本来就会恢复默认；屏蔽字要显式清空
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t empty;
+    sigemptyset(&empty);
+    posix_spawnattr_setsigmask(&attr, &empty);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+
+    // 直接 exec 缓存里的路径；文件已被删掉（ENOENT）时丢掉缓存重新查找一次
+    pid_t pid;
+    int err = ENOENT;
+    for (int attempt = 0; attempt < 2 && err == ENOENT; attempt++) {
+        // 带 / 的路径和 execvp 一样直接执行，不存在、没有执行权限等都由 posix_spawn 报出真正的原因
+        char *path = strchr(argv[0], '/') ? strdup(argv[0]) : cmd_hash_lookup(argv[0], 1);
+        if (!path) break;
+        err = posix_spawn(&pid, path, &actions, &attr, argv, environ);
+        if (err == ENOEXEC) err = spawn_script(&pid, path, argv, &actions, &attr);
+        free(path);
+        if (err != ENOENT || strchr(argv[0], '/')) break;
+        cmd_hash_forget(argv[0]);
+    }
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    if (err != 0) {
+        errno = err;
+        return -1;
+    }
+    return pid;
+}
+
+int spawn_report_error(const char *cmd) {
+    if (errno == ENOENT) {
+        fprintf(stderr, "Unknown command: %s\n", cmd);
+        return 127;
+    }
+    fprintf(stderr, "%s: %s\n", cmd, strerror(errno));
+    return 126;
+}
+
+int spawn_open_input(const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) perror("打开输入文件失败");
+    return fd;
+}
+
+int spawn_open_output(const char *path) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) perror("创建输出文件失败");
+    return fd;
+}
@@ -0,0 +1,25 @@
+#ifndef SPAWN_H
+#define SPAWN_H
+
+#include <sys/types.h>
+
+// 外部命令的启动层：用 posix_spawn（glibc 内部是 clone(CLONE_VM|CLONE_VFORK)）代替 fork + exec，
+// 子进程不复制 shell 的页表，shell 占的内存越多省得越多。
+// 命令路径取自命令缓存（cmdhash.h），不再由 execvp 每次搜索 PATH。
+// 管道和重定向都作为 file action 在子进程里 dup2，调用者打开的描述符应带 O_CLOEXEC
+typedef struct {
+    int stdin_fd;     // 接到子进程标准输入的描述符，-1 为不变
+    int stdout_fd;    // 接到子进程标准输出的描述符，-1 为不变
+} SpawnIo;
+
+// 成功返回子进程 pid；失败返回 -1，errno 为原因（如命令不存在时为 ENOENT）。
+// 没有 #! 行的可执行脚本和 execvp 一样交给 /bin/sh
+pid_t spawn_command(char **argv, const SpawnIo *io);
+// spawn_command 失败后按 errno 报错：命令不存在时报 Unknown command，其它给出原因；
+// 返回对应的退出状态（不存在 127，存在但不能执行 126）
+int spawn_report_error(const char *cmd);
+// 打开 < / > 重定向的文件（带 O_CLOEXEC），出错时按原来的提示报错并返回 -1
+int spawn_open_input(const char *path);
+int spawn_open_output(const char *path);
+
+#endif
@@ -0,0 +1,283 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include "statbatch.h"
+
+#ifdef HAVE_IO_URING
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/vfs.h>
+#include <linux/io_uring.h>
+
+#define RING_ENTRIES 256
+#endif
+
+struct StatBatch {
+    int ring_fd;           // -1 时逐个 fstatat
+#ifdef HAVE_IO_URING
+    unsigned sq_entries;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ring, *cq_ring;
+    size_t sq_ring_size, cq_ring_size, sqes_size;
+    struct statx *stx;     // 每个在途请求一份结果缓冲
+    int force_ring;        // 本地文件系统也走 io_uring
+    int ring_tried;        // 已尝试过建环（第一次真要用时才建，成败都只试一次）
+#endif
+};
+
+static void stat_sync(int dirfd, char *const *names, int n, int flags,
+                      struct stat *out, int *errs) {
+    for (int i = 0; i < n; i++) {
+        errs[i] = fstatat(dirfd, names[i], &out[i], flags) == 0 ? 0 : errno;
+    }
+}
+
+#ifdef HAVE_IO_URING
+// glibc 没有 io_uring 的包装，直接走 syscall，不依赖 liburing
+static int ring_setup(unsigned entries, struct io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int ring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int ring_register(int fd, unsigned opcode, void *arg, unsigned nr_args) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+// 内核版本不够新（5.6 之前）时没有 STATX 操作，探测一下
+static int ring_supports_statx(int fd) {
+    size_t size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = calloc(1, size);
+    if (!probe) return 0;
+    int ok = ring_register(fd, IORING_REGISTER_PROBE, probe, 256) == 0 &&
+             probe->last_op >= IORING_OP_STATX &&
+             (probe->ops[IORING_OP_STATX].flags & IO_URING_OP_SUPPORTED);
+    free(probe);
+    return ok;
+}
+
+static void ring_close(StatBatch *b) {
+    if (b->sqes && b->sqes != MAP_FAILED) munmap(b->sqes, b->sqes_size);
+    if (b->cq_ring && b->cq_ring != MAP_FAILED && b->cq_ring != b->sq_ring) {
+        munmap(b->cq_ring, b->cq_ring_size);
+    }
+    if (b->sq_ring && b->sq_ring != MAP_FAILED) munmap(b->sq_ring, b->sq_ring_size);
+    free(b->stx);
+    if (b->ring_fd >= 0) close(b->ring_fd);
+    b->ring_fd = -1;
+}
+
+static int ring_open(StatBatch *b) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    b->ring_fd = ring_setup(RING_ENTRIES, &p);
+    if (b->ring_fd < 0) return -1;
+    if (!ring_supports_statx(b->ring_fd)) goto fail;
+
+    b->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    b->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (b->cq_ring_size > b->sq_ring_size) b->sq_ring_size = b->cq_ring_size;
+    }
+    b->sq_ring = mmap(NULL, b->sq_ring_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, b->ring_fd, IORING_OFF_SQ_RING);
+    if (b->sq_ring == MAP_FAILED) goto fail;
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        b->cq_ring = b->sq_ring;
+    } else {
+        b->cq_ring = mmap(NULL, b->cq_ring_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, b->ring_fd, IORING_OFF_CQ_RING);
+        if (b->cq_ring == MAP_FAILED) goto fail;
+    }
+    b->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    b->sqes = mmap(NULL, b->sqes_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, b->ring_fd, IORING_OFF_SQES);
+    if (b->sqes == MAP_FAILED) goto fail;
+
+    char *sq = b->sq_ring, *cq = b->cq_ring;
+    b->sq_entries = p.sq_entries;
+    b->sq_head = (unsigned *)(sq + p.sq_off.head);
+    b->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    b->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    b->sq_array = (unsigned *)(sq + p.sq_off.array);
+    b->cq_head = (unsigned *)(cq + p.cq_off.head);
+    b->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    b->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    b->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+    // 在途请求不超过 sq_entries 个，按提交槽位编号复用结果缓冲
+    b->stx = malloc(p.sq_entries * sizeof(struct statx));
+    if (!b->stx) goto fail;
+    return 0;
+
+fail:
+    ring_close(b);
+    return -1;
+}
+
+// 本地文件系统上 stat 只要几微秒，io_uring 把 statx 交给内核工作线程反而更慢；
+// 只有每次 stat 都要等网络往返的文件系统才值得并发提交
+static int is_remote_fs(int dirfd) {
+    struct statfs fs;
+    if (dirfd == AT_FDCWD ? statfs(".", &fs) != 0 : fstatfs(dirfd, &fs) != 0) return 0;
+    switch ((unsigned long)fs.f_type) {
+    case 0x6969:       // NFS
+    case 0xff534d42:   // CIFS
+    case 0xfe534d42:   // SMB2
+    case 0x517b:       // SMB
+    case 0x65735546:   // FUSE（sshfs 等）
+    case 0x00c36400:   // Ceph
+    case 0x5346414f:   // AFS
+    case 0x01021997:   // 9P
+    case 0x47504653:   // GPFS
+    case 0x0bd00bd0:   // Lustre
+        return 1;
+    }
+    return 0;
+}
+
+static void statx_to_stat(const struct statx *x, struct stat *st) {
+    memset(st, 0, sizeof(*st));
+    st->st_dev = makedev(x->stx_dev_major, x->stx_dev_minor);
+    st->st_ino = x->stx_ino;
+    st->st_mode = x->stx_mode;
+    st->st_nlink = x->stx_nlink;
+    st->st_uid = x->stx_uid;
+    st->st_gid = x->stx_gid;
+    st->st_rdev = makedev(x->stx_rdev_major, x->stx_rdev_minor);
+    st->st_size = x->stx_size;
+    st->st_blksize = x->stx_blksize;
+    st->st_blocks = x->stx_blocks;
+    st->st_atim.tv_sec = x->stx_atime.tv_sec;
+    st->st_atim.tv_nsec = x->stx_atime.tv_nsec;
+    st->st_mtim.tv_sec = x->stx_mtime.tv_sec;
+    st->st_mtim.tv_nsec = x->stx_mtime.tv_nsec;
+    st->st_ctim.tv_sec = x->stx_ctime.tv_sec;
+    st->st_ctim.tv_nsec = x->stx_ctime.tv_nsec;
+}
+
+// 能提交就一直提交，队列满了再收完成项；完成的先后不定，靠 user_data 找回对应条目
+static int stat_ring(StatBatch *b, int dirfd, char *const *names, int n, int flags,
+                     struct stat *out, int *errs) {
+    // 每个在途请求占一个结果缓冲：slot_of[k] 是缓冲 k 对应的条目，free_slots 是空闲缓冲
+    int *slot_of = malloc(b->sq_entries * sizeof(int));
+    unsigned *free_slots = malloc(b->sq_entries * sizeof(unsigned));
+    if (!slot_of || !free_slots) {
+        free(slot_of);
+        free(free_slots);
+        return -1;
+    }
+    unsigned nfree = b->sq_entries;
+    for (unsigned k = 0; k < nfree; k++) free_slots[k] = k;
+
+    // pending：已放进提交队列、内核还没取走的；inflight：放进队列、还没收到完成的
+    int next = 0, inflight = 0;
+    unsigned pending = 0;
+    while (next < n || inflight > 0) {
+        unsigned tail = *b->sq_tail;
+        while (next < n && nfree > 0) {
+            unsigned k = free_slots[--nfree];
+            unsigned idx = tail & *b->sq_mask;
+            struct io_uring_sqe *sqe = &b->sqes[idx];
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = dirfd;
+            sqe->addr = (uint64_t)(uintptr_t)names[next];
+            sqe->len = STATX_BASIC_STATS;
+            sqe->off = (uint64_t)(uintptr_t)&b->stx[k];
+            sqe->statx_flags = flags;
+            sqe->user_data = k;
+            b->sq_array[idx] = idx;
+            slot_of[k] = next++;
+            tail++;
+            pending++;
+            inflight++;
+        }
+        __atomic_store_n(b->sq_tail, tail, __ATOMIC_RELEASE);
+
+        int r = ring_enter(b->ring_fd, pending, 1, IORING_ENTER_GETEVENTS);
+        if (r >= 0) {
+            pending -= r;
+        } else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            // 环不能用了：关掉后由调用者整批改用 fstatat 重做。
+            // 还有请求在途时内核工作线程可能稍后才往结果缓冲里写，这块缓冲不能释放，只能放弃不用
+            if (inflight > 0) b->stx = NULL;
+            ring_close(b);
+            free(slot_of);
+            free(free_slots);
+            return -1;
+        }
+
+        unsigned head = *b->cq_head;
+        unsigned cq_tail = __atomic_load_n(b->cq_tail, __ATOMIC_ACQUIRE);
+        while (head != cq_tail) {
+            struct io_uring_cqe *cqe = &b->cqes[head & *b->cq_mask];
+            unsigned k = (unsigned)cqe->user_data;
+            int i = slot_of[k];
+            if (cqe->res < 0) {
+                errs[i] = -cqe->res;
+            } else {
+                errs[i] = 0;
+                statx_to_stat(&b->stx[k], &out[i]);
+            }
+            free_slots[nfree++] = k;
+            inflight--;
+            head++;
+        }
+        __atomic_store_n(b->cq_head, head, __ATOMIC_RELEASE);
+    }
+    free(slot_of);
+    free(free_slots);
+    return 0;
+}
+#endif
+
+StatBatch *stat_batch_new(void) {
+    StatBatch *b = calloc(1, sizeof(StatBatch));
+    if (!b) return NULL;
+    b->ring_fd = -1;
+#ifdef HAVE_IO_URING
+    // 环境变量 DESHELL_IO_URING=0 时总是逐个 stat，=1 时本地文件系统也用 io_uring，便于对比
+    const char *env = getenv("DESHELL_IO_URING");
+    b->ring_tried = env && strcmp(env, "0") == 0;
+    b->force_ring = env && strcmp(env, "1") == 0;
+#endif
+    return b;
+}
+
+void stat_batch_run(StatBatch *b, int dirfd, char *const *names, int n, int flags,
+                    struct stat *out, int *errs) {
+#ifdef HAVE_IO_URING
+    // 只有一两个条目时直接 stat 更快；环到第一次真要用时才建，本地文件系统上从不建
+    if (b && n > 2 && (b->force_ring || is_remote_fs(dirfd))) {
+        if (!b->ring_tried) {
+            b->ring_tried = 1;
+            ring_open(b);
+        }
+        if (b->ring_fd >= 0 && stat_ring(b, dirfd, names, n, flags, out, errs) == 0) return;
+    }
+#else
+    (void)b;
+#endif
+    stat_sync(dirfd, names, n, flags, out, errs);
+}
+
+void stat_batch_free(StatBatch *b) {
+    if (!b) return;
+#ifdef HAVE_IO_URING
+    if (b->ring_fd >= 0) ring_close(b);
+#endif
+    free(b);
+}
@@ -0,0 +1,20 @@
+#ifndef STATBATCH_H
+#define STATBATCH_H
+
+#include <sys/stat.h>
+
+// 批量取元数据：一个目录里要 stat 的条目一次全部提交（io_uring 的 IORING_OP_STATX），
+// 完成一个收一个，网络文件系统（NFS、SMB、FUSE 等）上不必一个个等往返；本地文件系统仍逐个 fstatat。
+// 编译时没有 linux/io_uring.h、或运行时内核不支持 / 被禁用时，退回逐个 fstatat。
+// io_uring 的环在第一次需要时才建立，只在本地文件系统上用的 StatBatch 不占任何环资源。
+// 一个 StatBatch 只能由一个线程使用
+typedef struct StatBatch StatBatch;
+
+StatBatch *stat_batch_new(void);
+// 对 dirfd 下的 names[0..n) 取元数据，flags 同 fstatat（0 或 AT_SYMLINK_NOFOLLOW）；
+// 成功的 errs[i] 为 0、结果在 out[i]，失败的 errs[i] 为 errno
+void stat_batch_run(StatBatch *b, int dirfd, char *const *names, int n, int flags,
+                    struct stat *out, int *errs);
+void stat_batch_free(StatBatch *b);
+
+#endif
@@ -0,0 +1,110 @@
+// 内置 DFA 与 glibc regexec 的结果对照：grep 默认先用 DFA，编译不了才退回 regexec，两者结果必须一致
+// 用法：make check
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <regex.h>
+#include "../dfa.h"
+
+static const char *lines[] = {
+    "foo bar", "<foo", "foo>", "`foo", "foo'", "barfoo", "foo_bar", "a foo", "foo",
+    "", "x", " foo ", "f o o", "FOO", "foofoo", "b", "ab", "aab", "aaab", "aaaab", "a{,3}b",
+    "abcd", "xabcdabc", "aaaaaaac", "a a a a", "foo bar foo baz foo",
+};
+#define NLINES (sizeof(lines) / sizeof(lines[0]))
+
+static int failures;
+
+// expect_fallback 非 0 时 DFA 必须拒绝编译（交给 regexec）
+static void check(const char *pattern, int expect_fallback) {
+    regex_t re;
+    if (regcomp(&re, pattern, REG_EXTENDED) != 0) {
+        printf("FAIL %-12s regcomp failed\n", pattern);
+        failures++;
+        return;
+    }
+    Dfa *dfa = dfa_compile(pattern, 0);
+    if (dfa && expect_fallback) {
+        printf("FAIL %-12s dfa accepted a pattern it must leave to regexec\n", pattern);
+        failures++;
+    }
+    if (!dfa && !expect_fallback) {
+        printf("FAIL %-12s dfa rejected a pattern it should compile\n", pattern);
+        failures++;
+    }
+    for (size_t i = 0; dfa && i < NLINES; i++) {
+        size_t n = strlen(lines[i]);
+        regmatch_t m = {0, (regoff_t)n};
+        int libc = regexec(&re, lines[i], 1, &m, REG_STARTEND) == 0;
+        int ours = dfa_match(dfa, lines[i], n);
+        size_t start, end;
+        int found = dfa_find(dfa, lines[i], n, 0, &start, &end);
+        if (ours != libc || found != libc ||
+            (libc && (start != (size_t)m.rm_so || end != (size_t)m.rm_eo))) {
+            printf("FAIL %-12s line \"%s\": libc %d [%d,%d) dfa %d find %d [%zu,%zu)\n", pattern,
+                   lines[i], libc, (int)m.rm_so, (int)m.rm_eo, ours, found, found ? start : 0,
+                   found ? end : 0);
+            failures++;
+        }
+    }
+    // 像 grep -o 那样从上一个匹配的结尾接着找，逐个对照
+    for (size_t i = 0; dfa && i < NLINES; i++) {
+        size_t n = strlen(lines[i]);
+        for (size_t from = 0; from <= n; ) {
+            regmatch_t m = {(regoff_t)from, (regoff_t)n};
+            int libc = regexec(&re, lines[i], 1, &m, REG_STARTEND | (from ? REG_NOTBOL : 0)) == 0;
+            size_t start = 0, end = 0;
+            int found = dfa_find(dfa, lines[i], n, from, &start, &end);
+            if (found != libc || (libc && (start != (size_t)m.rm_so || end != (size_t)m.rm_eo))) {
+                printf("FAIL %-12s line \"%s\" from %zu: libc %d [%d,%d) dfa %d [%zu,%zu)\n", pattern,
+                       lines[i], from, libc, (int)m.rm_so, (int)m.rm_eo, found, start, end);
+                failures++;
+                break;
+            }
+            if (!found) break;
+            from = end > start ? end : end + 1;
+        }
+    }
+    if (dfa) dfa_free(dfa);
+    regfree(&re);
+}
+
+int main(void) {
+    // GNU 扩展的锚点和字符类：DFA 不支持，必须退回 regexec
+    check("\\<foo", 1);
+    check("foo\\>", 1);
+    check("\\`foo", 1);
+    check("foo\\'", 1);
+    check("\\bfoo", 1);
+    check("\\Bfoo", 1);
+    check("\\w+", 1);
+    check("\\sfoo", 1);
+
+    // DFA 能编译的写法，逐行和 regexec 对照
+    check("foo", 0);
+    check("^foo$", 0);
+    check("\\.|<", 0);
+    check("o+", 0);
+    check("(foo|bar)+", 0);
+    check("a{2,3}b", 0);
+    check("a{,3}b", 0);
+    check("a{,}b", 0);
+    check("(ab){,2}c", 0);
+    check("[^ ]+o", 0);
+    check("abcd|c", 0);
+    check("a|a*c", 0);
+    check("(a*c|b)", 0);
+    check("^a", 0);
+    check("o*$", 0);
+    check("a*", 0);
+    check("^$", 0);
+    check("foo|foo bar", 0);
+
+    if (failures) {
+        printf("%d failure(s)\n", failures);
+        return 1;
+    }
+    printf("all passed\n");
+    return 0;
+}
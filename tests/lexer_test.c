@@ -0,0 +1,66 @@
+// 切词的引号与变量展开：单引号和 \$ 原样保留，不加引号和双引号里展开 $VAR
+// 用法：make check
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../lexer.h"
+
+static int failures;
+
+// expect 是以 NULL 结尾的期望词列表
+static void check(const char *line, const char **expect) {
+    Arena a;
+    arena_init(&a);
+    TokenList list;
+    const char *error;
+    if (lex_line(&a, line, &list, &error) != 0) {
+        printf("FAIL %-24s lex error: %s\n", line, error);
+        failures++;
+        arena_free(&a);
+        return;
+    }
+    int n = 0;
+    for (int i = 0; i < list.count && list.tokens[i].type == TOK_WORD; i++, n++) {
+        if (!expect[n] || strcmp(list.tokens[i].text, expect[n]) != 0) {
+            printf("FAIL %-24s word %d: got \"%s\", want \"%s\"\n", line, n, list.tokens[i].text,
+                   expect[n] ? expect[n] : "(none)");
+            failures++;
+            arena_free(&a);
+            return;
+        }
+    }
+    if (expect[n]) {
+        printf("FAIL %-24s missing word %d \"%s\"\n", line, n, expect[n]);
+        failures++;
+    }
+    arena_free(&a);
+}
+
+int main(void) {
+    setenv("HOME", "/home/tester", 1);
+    setenv("LONG", "a value much longer than the name it replaces", 1);
+    unsetenv("NOPE");
+
+    check("echo '$HOME'", (const char *[]){"echo", "$HOME", NULL});
+    check("echo \"$HOME\"", (const char *[]){"echo", "/home/tester", NULL});
+    check("echo \\$HOME", (const char *[]){"echo", "$HOME", NULL});
+    check("echo $HOME", (const char *[]){"echo", "/home/tester", NULL});
+    check("echo \"\\$HOME\"", (const char *[]){"echo", "$HOME", NULL});
+    check("echo x${HOME}y", (const char *[]){"echo", "x/home/testery", NULL});
+    check("echo \"a $HOME\" 'b $HOME'", (const char *[]){"echo", "a /home/tester", "b $HOME", NULL});
+    // 变量值比 $NAME 长，后面的词要挪到新缓冲
+    check("$LONG $LONG x", (const char *[]){"a value much longer than the name it replaces",
+                                             "a value much longer than the name it replaces", "x", NULL});
+    // 未设置的变量：不加引号时整个词去掉，加了引号是空词
+    check("echo $NOPE end", (const char *[]){"echo", "end", NULL});
+    check("echo \"$NOPE\" end", (const char *[]){"echo", "", "end", NULL});
+    // 不是变量名的 $ 原样保留
+    check("echo a$ $1 ${", (const char *[]){"echo", "a$", "$1", "${", NULL});
+
+    if (failures) {
+        printf("%d failure(s)\n", failures);
+        return 1;
+    }
+    printf("all passed\n");
+    return 0;
+}
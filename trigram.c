@@ -0,0 +1,598 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "trigram.h"
+
+#define TRI_MAGIC "DSHIDX1"
+#define TRI_SPACE (1u << 24)
+#define TRI_MAX_FILE_SIZE (256L * 1024 * 1024)  // 更大的文件不建索引，查询时总是扫描
+#define TRI_BINARY_PROBE (32 * 1024)
+
+typedef struct {
+    char *path;            // 相对索引根目录
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    int64_t size;
+    uint32_t indexed;      // 0：二进制、过大或读取失败
+    uint32_t *tris;        // 仅建索引时使用：该文件含有的三元组
+    uint32_t ntris;
+} TriFile;
+
+struct TrigramIndex {
+    uint32_t nfiles;
+    uint32_t ntrigrams;
+    TriFile *files;
+    uint32_t *keys;        // 有序三元组
+    uint32_t *counts;
+    uint64_t *offsets;     // 每个三元组在 postings 中的起点
+    uint32_t *postings;    // 文件编号，同一三元组内递增
+    int32_t *slots;        // 路径 -> 文件编号 的开放寻址哈希表
+    uint32_t nslots;
+    unsigned char *candidate;  // tri_restrict 的结果，NULL 表示不限定
+};
+
+static char *index_path(const char *dir, const char *suffix) {
+    char *path;
+    if (asprintf(&path, "%s/%s%s", dir, TRIGRAM_INDEX_NAME, suffix) < 0) return NULL;
+    return path;
+}
+
+static uint32_t hash_path(const char *s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void build_path_table(TrigramIndex *idx) {
+    idx->nslots = 16;
+    while (idx->nslots < idx->nfiles * 2) idx->nslots <<= 1;
+    idx->slots = malloc(idx->nslots * sizeof(int32_t));
+    memset(idx->slots, 0xff, idx->nslots * sizeof(int32_t));
+    for (uint32_t i = 0; i < idx->nfiles; i++) {
+        uint32_t h = hash_path(idx->files[i].path) & (idx->nslots - 1);
+        while (idx->slots[h] >= 0) h = (h + 1) & (idx->nslots - 1);
+        idx->slots[h] = i;
+    }
+}
+
+static int32_t find_file(const TrigramIndex *idx, const char *relpath) {
+    uint32_t h = hash_path(relpath) & (idx->nslots - 1);
+    while (idx->slots[h] >= 0) {
+        if (strcmp(idx->files[idx->slots[h]].path, relpath) == 0) return idx->slots[h];
+        h = (h + 1) & (idx->nslots - 1);
+    }
+    return -1;
+}
+
+static int stamp_matches(const TriFile *f, const struct stat *st) {
+    return f->size == (int64_t)st->st_size &&
+           f->mtime_sec == (int64_t)st->st_mtim.tv_sec &&
+           f->mtime_nsec == (int64_t)st->st_mtim.tv_nsec;
+}
+
+// 按顺序从内存中取数据，越界时置 ok = 0
+typedef struct {
+    const char *p;
+    const char *end;
+    int ok;
+} Cursor;
+
+static void take(Cursor *c, void *dst, size_t n) {
+    if (!c->ok || (size_t)(c->end - c->p) < n) {
+        c->ok = 0;
+        memset(dst, 0, n);
+        return;
+    }
+    memcpy(dst, c->p, n);
+    c->p += n;
+}
+
+void tri_free(TrigramIndex *idx) {
+    if (!idx) return;
+    for (uint32_t i = 0; i < idx->nfiles; i++) {
+        free(idx->files[i].path);
+        free(idx->files[i].tris);
+    }
+    free(idx->files);
+    free(idx->keys);
+    free(idx->counts);
+    free(idx->offsets);
+    free(idx->postings);
+    free(idx->slots);
+    free(idx->candidate);
+    free(idx);
+}
+
+TrigramIndex *tri_load(const char *dir) {
+    char *path = index_path(dir, "");
+    if (!path) return NULL;
+    int fd = open(path, O_RDONLY);
+    free(path);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 8) {
+        close(fd);
+        return NULL;
+    }
+    char *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return NULL;
+
+    Cursor c = { data, data + st.st_size, 1 };
+    char magic[8];
+    uint64_t npostings;
+    TrigramIndex *idx = calloc(1, sizeof(TrigramIndex));
+    take(&c, magic, sizeof(magic));
+    take(&c, &idx->nfiles, sizeof(uint32_t));
+    take(&c, &idx->ntrigrams, sizeof(uint32_t));
+    take(&c, &npostings, sizeof(uint64_t));
+    if (!c.ok || memcmp(magic, TRI_MAGIC, sizeof(magic)) != 0 ||
+        npostings > (uint64_t)st.st_size / sizeof(uint32_t) ||
+        idx->nfiles > (uint64_t)st.st_size || idx->ntrigrams > TRI_SPACE) {
+        munmap(data, st.st_size);
+        free(idx);
+        return NULL;
+    }
+
+    idx->files = calloc(idx->nfiles, sizeof(TriFile));
+    for (uint32_t i = 0; i < idx->nfiles && c.ok; i++) {
+        TriFile *f = &idx->files[i];
+        uint32_t len = 0;
+        take(&c, &f->mtime_sec, sizeof(int64_t));
+        take(&c, &f->mtime_nsec, sizeof(int64_t));
+        take(&c, &f->size, sizeof(int64_t));
+        take(&c, &f->indexed, sizeof(uint32_t));
+        take(&c, &len, sizeof(uint32_t));
+        if (!c.ok || (size_t)(c.end - c.p) < len) {
+            c.ok = 0;
+            break;
+        }
+        f->path = strndup(c.p, len);
+        c.p += len;
+    }
+
+    idx->keys = malloc((idx->ntrigrams + 1) * sizeof(uint32_t));
+    idx->counts = malloc((idx->ntrigrams + 1) * sizeof(uint32_t));
+    idx->offsets = malloc((idx->ntrigrams + 1) * sizeof(uint64_t));
+    uint64_t offset = 0;
+    for (uint32_t i = 0; i < idx->ntrigrams && c.ok; i++) {
+        take(&c, &idx->keys[i], sizeof(uint32_t));
+        take(&c, &idx->counts[i], sizeof(uint32_t));
+        idx->offsets[i] = offset;
+        offset += idx->counts[i];
+    }
+    if (offset != npostings) c.ok = 0;
+    idx->postings = malloc((npostings + 1) * sizeof(uint32_t));
+    take(&c, idx->postings, npostings * sizeof(uint32_t));
+    for (uint64_t i = 0; c.ok && i < npostings; i++) {
+        if (idx->postings[i] >= idx->nfiles) c.ok = 0;
+    }
+    munmap(data, st.st_size);
+
+    if (!c.ok) {
+        tri_free(idx);
+        return NULL;
+    }
+    build_path_table(idx);
+    return idx;
+}
+
+static uint32_t trigram_at(const unsigned char *p) {
+    return (uint32_t)tolower(p[0]) << 16 | (uint32_t)tolower(p[1]) << 8 | (uint32_t)tolower(p[2]);
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int64_t find_trigram(const TrigramIndex *idx, uint32_t t) {
+    int64_t lo = 0, hi = (int64_t)idx->ntrigrams - 1;
+    while (lo <= hi) {
+        int64_t mid = (lo + hi) / 2;
+        if (idx->keys[mid] == t) return mid;
+        if (idx->keys[mid] < t) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return -1;
+}
+
+int tri_restrict(TrigramIndex *idx, char **literals, int count) {
+    free(idx->candidate);
+    idx->candidate = NULL;
+    if (count == 0) return 0;
+    for (int i = 0; i < count; i++) {
+        if (!literals[i] || strlen(literals[i]) < 3) return 0;
+    }
+
+    unsigned char *candidate = calloc(idx->nfiles + 1, 1);
+    uint32_t *hits = calloc(idx->nfiles + 1, sizeof(uint32_t));
+    for (int i = 0; i < count; i++) {
+        // 字面串的所有三元组（去重）都出现的文件才可能包含它
+        size_t len = strlen(literals[i]);
+        size_t n = len - 2;
+        uint32_t *tris = malloc(n * sizeof(uint32_t));
+        for (size_t k = 0; k < n; k++) {
+            tris[k] = trigram_at((const unsigned char *)literals[i] + k);
+        }
+        qsort(tris, n, sizeof(uint32_t), compare_u32);
+        size_t distinct = 0;
+        for (size_t k = 0; k < n; k++) {
+            if (k == 0 || tris[k] != tris[k - 1]) tris[distinct++] = tris[k];
+        }
+
+        memset(hits, 0, idx->nfiles * sizeof(uint32_t));
+        int missing = 0;
+        for (size_t k = 0; k < distinct && !missing; k++) {
+            int64_t slot = find_trigram(idx, tris[k]);
+            if (slot < 0) {
+                missing = 1;
+                break;
+            }
+            const uint32_t *post = idx->postings + idx->offsets[slot];
+            for (uint32_t j = 0; j < idx->counts[slot]; j++) {
+                hits[post[j]]++;
+            }
+        }
+        for (uint32_t f = 0; f < idx->nfiles && !missing; f++) {
+            if (hits[f] == distinct) candidate[f] = 1;
+        }
+        free(tris);
+    }
+    free(hits);
+
+    for (uint32_t f = 0; f < idx->nfiles; f++) {
+        if (!idx->files[f].indexed) candidate[f] = 1;
+    }
+    idx->candidate = candidate;
+    return 1;
+}
+
+int tri_may_match(const TrigramIndex *idx, const char *relpath, const struct stat *st) {
+    if (!idx->candidate) return 1;
+    int32_t id = find_file(idx, relpath);
+    if (id < 0) return 1;                          // 建索引后新增的文件
+    if (!stamp_matches(&idx->files[id], st)) return 1;  // 改动过，索引已过期
+    return idx->candidate[id];
+}
+
+// ---- 建索引 ----
+
+typedef struct {
+    TriFile *files;
+    uint32_t count;
+    uint32_t cap;
+} FileList;
+
+static void collect_files(const char *root, const char *rel, FileList *list) {
+    char *dirpath;
+    if (asprintf(&dirpath, "%s%s%s", root, rel[0] ? "/" : "", rel) < 0) return;
+    DIR *dir = opendir(dirpath);
+    if (!dir) {
+        perror(dirpath);
+        free(dirpath);
+        return;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        if (!rel[0] && strncmp(entry->d_name, TRIGRAM_INDEX_NAME, strlen(TRIGRAM_INDEX_NAME)) == 0) continue;
+
+        char *child_rel;
+        if (asprintf(&child_rel, "%s%s%s", rel, rel[0] ? "/" : "", entry->d_name) < 0) continue;
+        char *full;
+        if (asprintf(&full, "%s/%s", dirpath, entry->d_name) < 0) {
+            free(child_rel);
+            continue;
+        }
+
+        // 不跟随符号链接，避免环；grep 遇到链接时会当作新文件照常扫描
+        struct stat st;
+        if (lstat(full, &st) != 0) {
+            perror(full);
+        } else if (S_ISDIR(st.st_mode)) {
+            collect_files(root, child_rel, list);
+        } else if (S_ISREG(st.st_mode)) {
+            if (list->count == list->cap) {
+                list->cap = list->cap ? list->cap * 2 : 256;
+                list->files = realloc(list->files, list->cap * sizeof(TriFile));
+            }
+            TriFile *f = &list->files[list->count++];
+            memset(f, 0, sizeof(*f));
+            f->path = child_rel;
+            child_rel = NULL;
+            f->mtime_sec = st.st_mtim.tv_sec;
+            f->mtime_nsec = st.st_mtim.tv_nsec;
+            f->size = st.st_size;
+        }
+        free(child_rel);
+        free(full);
+    }
+    closedir(dir);
+    free(dirpath);
+}
+
+// 读文件求三元组集合；seen 是 2^24 位的位图，用完按列表清零
+static void scan_trigrams(const char *root, TriFile *f, unsigned char *seen) {
+    char *full;
+    if (asprintf(&full, "%s/%s", root, f->path) < 0) return;
+    int fd = open(full, O_RDONLY);
+    free(full);
+    if (fd < 0 || f->size > TRI_MAX_FILE_SIZE) {
+        if (fd >= 0) close(fd);
+        return;
+    }
+    if (f->size == 0) {
+        close(fd);
+        f->indexed = 1;
+        return;
+    }
+    const unsigned char *data = mmap(NULL, f->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return;
+
+    size_t probe = f->size < TRI_BINARY_PROBE ? f->size : TRI_BINARY_PROBE;
+    if (memchr(data, '\0', probe) == NULL) {
+        uint32_t cap = 1024;
+        f->tris = malloc(cap * sizeof(uint32_t));
+        for (int64_t i = 0; i + 2 < f->size; i++) {
+            // 跨行的三元组不会出现在任何模式里
+            if (data[i] == '\n' || data[i + 1] == '\n' || data[i + 2] == '\n') continue;
+            uint32_t t = trigram_at(data + i);
+            if (seen[t >> 3] & (1 << (t & 7))) continue;
+            seen[t >> 3] |= 1 << (t & 7);
+            if (f->ntris == cap) {
+                cap *= 2;
+                f->tris = realloc(f->tris, cap * sizeof(uint32_t));
+            }
+            f->tris[f->ntris++] = t;
+        }
+        for (uint32_t k = 0; k < f->ntris; k++) {
+            seen[f->tris[k] >> 3] = 0;
+        }
+        f->indexed = 1;
+    }
+    munmap((void *)data, f->size);
+}
+
+// 把旧索引的倒排表还原成每个文件的三元组列表，供未变化的文件直接沿用
+static void invert_postings(TrigramIndex *old) {
+    for (uint32_t t = 0; t < old->ntrigrams; t++) {
+        const uint32_t *post = old->postings + old->offsets[t];
+        for (uint32_t j = 0; j < old->counts[t]; j++) {
+            old->files[post[j]].ntris++;
+        }
+    }
+    for (uint32_t f = 0; f < old->nfiles; f++) {
+        old->files[f].tris = malloc((old->files[f].ntris + 1) * sizeof(uint32_t));
+        old->files[f].ntris = 0;
+    }
+    for (uint32_t t = 0; t < old->ntrigrams; t++) {
+        const uint32_t *post = old->postings + old->offsets[t];
+        for (uint32_t j = 0; j < old->counts[t]; j++) {
+            TriFile *f = &old->files[post[j]];
+            f->tris[f->ntris++] = old->keys[t];
+        }
+    }
+}
+
+// 建索引时只为出现过的三元组计数：开放寻址的哈希表，装到一半就翻倍。
+// 大小跟着实际出现的三元组走，而不是按 2^24 的整个空间开数组
+typedef struct {
+    uint32_t *keys;        // 三元组 + 1，0 表示空槽
+    uint64_t *values;      // 先是出现次数，排好序后改成在 postings 中的写入位置
+    uint32_t nslots;
+    uint32_t used;
+} TriCounts;
+
+static uint32_t tri_slot(const TriCounts *c, uint32_t t) {
+    uint32_t h = (t * 2654435761u) & (c->nslots - 1);
+    while (c->keys[h] && c->keys[h] != t + 1) h = (h + 1) & (c->nslots - 1);
+    return h;
+}
+
+static int tri_counts_grow(TriCounts *c) {
+    TriCounts bigger = {0};
+    bigger.nslots = c->nslots ? c->nslots * 2 : 4096;
+    bigger.keys = calloc(bigger.nslots, sizeof(uint32_t));
+    bigger.values = malloc(bigger.nslots * sizeof(uint64_t));
+    if (!bigger.keys || !bigger.values) {
+        free(bigger.keys);
+        free(bigger.values);
+        return -1;
+    }
+    for (uint32_t i = 0; i < c->nslots; i++) {
+        if (!c->keys[i]) continue;
+        uint32_t h = tri_slot(&bigger, c->keys[i] - 1);
+        bigger.keys[h] = c->keys[i];
+        bigger.values[h] = c->values[i];
+    }
+    bigger.used = c->used;
+    free(c->keys);
+    free(c->values);
+    *c = bigger;
+    return 0;
+}
+
+static int tri_counts_add(TriCounts *c, uint32_t t) {
+    if ((c->used + 1) * 2 > c->nslots && tri_counts_grow(c) < 0) return -1;
+    uint32_t h = tri_slot(c, t);
+    if (!c->keys[h]) {
+        c->keys[h] = t + 1;
+        c->values[h] = 0;
+        c->used++;
+    }
+    c->values[h]++;
+    return 0;
+}
+
+static int write_index(const char *dir, FileList *list) {
+    // 统计每个出现过的三元组在多少个文件里，排序后按三元组顺序排出倒排表
+    TriCounts table = {0};
+    uint64_t npostings = 0;
+    for (uint32_t f = 0; f < list->count; f++) {
+        for (uint32_t k = 0; k < list->files[f].ntris; k++) {
+            if (tri_counts_add(&table, list->files[f].tris[k]) < 0) {
+                free(table.keys);
+                free(table.values);
+                return -1;
+            }
+        }
+        npostings += list->files[f].ntris;
+    }
+    uint32_t ntrigrams = table.used;
+
+    uint32_t *keys = malloc((ntrigrams + 1) * sizeof(uint32_t));
+    uint32_t *counts = malloc((ntrigrams + 1) * sizeof(uint32_t));
+    uint32_t *postings = malloc((npostings + 1) * sizeof(uint32_t));
+    if (!keys || !counts || !postings) {
+        free(table.keys);
+        free(table.values);
+        free(keys);
+        free(counts);
+        free(postings);
+        return -1;
+    }
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < table.nslots; i++) {
+        if (table.keys[i]) keys[n++] = table.keys[i] - 1;
+    }
+    qsort(keys, ntrigrams, sizeof(uint32_t), compare_u32);
+    uint64_t offset = 0;
+    for (uint32_t i = 0; i < ntrigrams; i++) {
+        uint32_t h = tri_slot(&table, keys[i]);
+        counts[i] = table.values[h];
+        table.values[h] = offset;
+        offset += counts[i];
+    }
+    for (uint32_t f = 0; f < list->count; f++) {
+        for (uint32_t k = 0; k < list->files[f].ntris; k++) {
+            postings[table.values[tri_slot(&table, list->files[f].tris[k])]++] = f;
+        }
+    }
+    free(table.keys);
+    free(table.values);
+
+    char *tmp = index_path(dir, ".tmp");
+    char *final = index_path(dir, "");
+    FILE *fp = tmp ? fopen(tmp, "wb") : NULL;
+    int rc = -1;
+    if (fp) {
+        char magic[8] = TRI_MAGIC;
+        fwrite(magic, 1, sizeof(magic), fp);
+        fwrite(&list->count, sizeof(uint32_t), 1, fp);
+        fwrite(&ntrigrams, sizeof(uint32_t), 1, fp);
+        fwrite(&npostings, sizeof(uint64_t), 1, fp);
+        for (uint32_t f = 0; f < list->count; f++) {
+            TriFile *tf = &list->files[f];
+            uint32_t len = strlen(tf->path);
+            fwrite(&tf->mtime_sec, sizeof(int64_t), 1, fp);
+            fwrite(&tf->mtime_nsec, sizeof(int64_t), 1, fp);
+            fwrite(&tf->size, sizeof(int64_t), 1, fp);
+            fwrite(&tf->indexed, sizeof(uint32_t), 1, fp);
+            fwrite(&len, sizeof(uint32_t), 1, fp);
+            fwrite(tf->path, 1, len, fp);
+        }
+        for (uint32_t i = 0; i < ntrigrams; i++) {
+            fwrite(&keys[i], sizeof(uint32_t), 1, fp);
+            fwrite(&counts[i], sizeof(uint32_t), 1, fp);
+        }
+        fwrite(postings, sizeof(uint32_t), npostings, fp);
+        if (fclose(fp) == 0 && rename(tmp, final) == 0) rc = 0;
+    }
+    if (rc != 0) {
+        perror(tmp ? tmp : "index");
+        if (tmp) unlink(tmp);
+    }
+    free(tmp);
+    free(final);
+    free(keys);
+    free(counts);
+    free(postings);
+    return rc;
+}
+
+int tri_build(const char *dir) {
+    FileList list = {0};
+    collect_files(dir, "", &list);
+
+    TrigramIndex *old = tri_load(dir);
+    if (old) invert_postings(old);
+
+    unsigned char *seen = calloc(TRI_SPACE / 8, 1);
+    if (!seen) {
+        perror("index");
+        tri_free(old);
+        return -1;
+    }
+    uint32_t reused = 0, skipped = 0;
+    for (uint32_t i = 0; i < list.count; i++) {
+        TriFile *f = &list.files[i];
+        int32_t id = old ? find_file(old, f->path) : -1;
+        if (id >= 0 && old->files[id].indexed &&
+            old->files[id].size == f->size && old->files[id].mtime_sec == f->mtime_sec &&
+            old->files[id].mtime_nsec == f->mtime_nsec) {
+            // 未变化：直接拿走旧索引里的三元组
+            f->tris = old->files[id].tris;
+            f->ntris = old->files[id].ntris;
+            f->indexed = 1;
+            old->files[id].tris = NULL;
+            reused++;
+        } else {
+            scan_trigrams(dir, f, seen);
+        }
+        if (!f->indexed) skipped++;
+    }
+    free(seen);
+    tri_free(old);
+
+    int rc = write_index(dir, &list);
+    if (rc == 0) {
+        printf("index: %u files (%u unchanged, %u not indexed) in %s/%s\n",
+               list.count, reused, skipped, dir, TRIGRAM_INDEX_NAME);
+    }
+    for (uint32_t i = 0; i < list.count; i++) {
+        free(list.files[i].path);
+        free(list.files[i].tris);
+    }
+    free(list.files);
+    return rc;
+}
+
+int tri_status(const char *dir) {
+    TrigramIndex *idx = tri_load(dir);
+    if (!idx) {
+        fprintf(stderr, "index: no index in %s\n", dir);
+        return -1;
+    }
+    uint32_t stale = 0, unindexed = 0;
+    uint64_t npostings = 0;
+    for (uint32_t t = 0; t < idx->ntrigrams; t++) {
+        npostings += idx->counts[t];
+    }
+    for (uint32_t i = 0; i < idx->nfiles; i++) {
+        char *full;
+        struct stat st;
+        if (!idx->files[i].indexed) unindexed++;
+        if (asprintf(&full, "%s/%s", dir, idx->files[i].path) < 0) continue;
+        if (stat(full, &st) != 0 || !stamp_matches(&idx->files[i], &st)) stale++;
+        free(full);
+    }
+    printf("files: %u (%u not indexed, %u changed since build)\n", idx->nfiles, unindexed, stale);
+    printf("trigrams: %u, postings: %llu\n", idx->ntrigrams, (unsigned long long)npostings);
+    tri_free(idx);
+    return 0;
+}
@@ -0,0 +1,25 @@
+#ifndef TRIGRAM_H
+#define TRIGRAM_H
+
+#include <sys/stat.h>
+
+// 目录树的三元组（trigram）索引，存放在 DIR/.deshell_index。
+// 每个文件记录 mtime/size；grep -r 先用模式里的字面串查出候选文件，
+// 未变化且不含这些三元组的文件直接跳过，变化过或新增的文件照常扫描
+#define TRIGRAM_INDEX_NAME ".deshell_index"
+
+typedef struct TrigramIndex TrigramIndex;
+
+// 建立或增量更新 dir 的索引，未变化的文件沿用旧索引的三元组；失败返回 -1
+int tri_build(const char *dir);
+// 打印索引概况；没有索引返回 -1
+int tri_status(const char *dir);
+
+TrigramIndex *tri_load(const char *dir);
+// 限定候选文件：匹配必须包含 literals 中的某一个（任一为 NULL 或短于 3 字节则不限定）
+int tri_restrict(TrigramIndex *idx, char **literals, int count);
+// relpath 相对索引根目录；返回 0 表示文件未变化且不可能匹配，可以跳过
+int tri_may_match(const TrigramIndex *idx, const char *relpath, const struct stat *st);
+void tri_free(TrigramIndex *idx);
+
+#endif
@@ -0,0 +1,453 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "walk.h"
+#include "dirread.h"
+#include "statbatch.h"
+
+#define WALK_MAX_THREADS 64
+
+// 路径只用于输出；打开文件和子目录都相对上级目录的描述符（openat / fstatat），
+// 不必每次从头解析整条路径
+typedef struct WalkNode {
+    char *path;
+    const char *name;          // path 的最后一段，相对 parent->fd
+    struct WalkNode *parent;
+    int fd;                    // 目录：展开时打开，子项都用完后关闭
+    atomic_int fd_users;       // 还要用到 fd 的子项数
+    int is_dir;
+    unsigned char d_type;      // 目录项里的类型，展开时用
+    int has_stat;              // 1：st 有效（want_stat 时展开目录批量取得）；-1：stat 失败
+    struct stat st;
+    dev_t dev;                 // 目录：展开时记下，用来发现成环
+    ino_t ino;
+    int done;                  // 目录：子项已列出；文件：输出已写完
+    long long weight;          // visit_file / visit_dir 的返回值，输出时按目录累加
+    void *dir_ctx;             // 所在目录的上下文（enter_dir 的返回值）
+    struct WalkNode **children;
+    int child_count;
+    char *output;
+    size_t output_len;
+} WalkNode;
+
+// 每个工作线程一个双端队列：自己从尾部取（深度优先），窃取者从头部取
+typedef struct {
+    pthread_mutex_t lock;
+    WalkNode **items;
+    size_t head, tail, cap;
+} WalkDeque;
+
+typedef struct {
+    WalkOptions *opts;
+    int nthreads;
+    WalkDeque *deques;
+    StatBatch **stats;         // 每个工作线程一个
+    atomic_long queued;        // 尚在队列中的任务数
+    atomic_long pending;       // 尚未完成的任务数
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;  // 有新任务或全部完成
+    pthread_cond_t done_cond;  // 输出线程等的节点完成了
+    WalkNode *waiting;         // 输出线程正在等的节点，别的节点完成时不必唤醒它
+} Walk;
+
+typedef struct {
+    Walk *walk;
+    int id;
+} WalkWorker;
+
+int walk_default_threads(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) n = 1;
+    if (n > WALK_MAX_THREADS) n = WALK_MAX_THREADS;
+    return (int)n;
+}
+
+static WalkNode *node_new(char *path, int is_dir) {
+    WalkNode *n = calloc(1, sizeof(WalkNode));
+    if (!n) {
+        free(path);
+        return NULL;
+    }
+    n->path = path;
+    n->name = path;
+    n->fd = -1;
+    n->is_dir = is_dir;
+    return n;
+}
+
+static void deque_push(Walk *w, int id, WalkNode *n) {
+    WalkDeque *d = &w->deques[id];
+    pthread_mutex_lock(&d->lock);
+    if (d->tail == d->cap) {
+        // 先把已取走的头部空位挪掉，仍不够再扩容
+        if (d->head > 0) {
+            memmove(d->items, d->items + d->head, (d->tail - d->head) * sizeof(WalkNode *));
+            d->tail -= d->head;
+            d->head = 0;
+        }
+        if (d->tail == d->cap) {
+            size_t cap = d->cap ? d->cap * 2 : 64;
+            d->items = realloc(d->items, cap * sizeof(WalkNode *));
+            d->cap = cap;
+        }
+    }
+    d->items[d->tail++] = n;
+    pthread_mutex_unlock(&d->lock);
+
+    atomic_fetch_add(&w->queued, 1);
+    pthread_mutex_lock(&w->lock);
+    pthread_cond_signal(&w->work_cond);
+    pthread_mutex_unlock(&w->lock);
+}
+
+static WalkNode *deque_take(Walk *w, int id, int steal) {
+    WalkDeque *d = &w->deques[id];
+    WalkNode *n = NULL;
+    pthread_mutex_lock(&d->lock);
+    if (d->head < d->tail) {
+        n = steal ? d->items[d->head++] : d->items[--d->tail];
+        if (d->head == d->tail) d->head = d->tail = 0;
+    }
+    pthread_mutex_unlock(&d->lock);
+    if (n) atomic_fetch_sub(&w->queued, 1);
+    return n;
+}
+
+static WalkNode *next_task(Walk *w, int id) {
+    while (1) {
+        WalkNode *n = deque_take(w, id, 0);
+        for (int k = 1; !n && k < w->nthreads; k++) {
+            n = deque_take(w, (id + k) % w->nthreads, 1);
+        }
+        if (n) return n;
+
+        pthread_mutex_lock(&w->lock);
+        while (atomic_load(&w->queued) == 0 && atomic_load(&w->pending) > 0) {
+            pthread_cond_wait(&w->work_cond, &w->lock);
+        }
+        int finished = atomic_load(&w->pending) == 0;
+        pthread_mutex_unlock(&w->lock);
+        if (finished) return NULL;
+    }
+}
+
+static void node_finish(Walk *w, WalkNode *n) {
+    pthread_mutex_lock(&w->lock);
+    n->done = 1;
+    if (n == w->waiting) pthread_cond_signal(&w->done_cond);
+    if (atomic_fetch_sub(&w->pending, 1) == 1) {
+        pthread_cond_broadcast(&w->work_cond);
+    }
+    pthread_mutex_unlock(&w->lock);
+}
+
+static int compare_nodes(const void *a, const void *b) {
+    const WalkNode *x = *(WalkNode * const *)a;
+    const WalkNode *y = *(WalkNode * const *)b;
+    return strcmp(x->path, y->path);
+}
+
+// 目录的 (st_dev, st_ino) 与某个祖先相同时说明符号链接成环
+static int is_loop(const WalkNode *node) {
+    for (const WalkNode *a = node->parent; a; a = a->parent) {
+        if (a->dev == node->dev && a->ino == node->ino) return 1;
+    }
+    return 0;
+}
+
+// 子项用完上级目录的描述符，最后一个用完的负责关闭
+static void release_parent(WalkNode *node) {
+    WalkNode *parent = node->parent;
+    if (parent && atomic_fetch_sub(&parent->fd_users, 1) == 1) {
+        close(parent->fd);
+        parent->fd = -1;
+    }
+}
+
+// 不跟随符号链接时，链接本身就是一个非目录条目，类型也算已知
+static int type_known(const WalkOptions *opts, const WalkNode *c) {
+    return c->d_type != DT_UNKNOWN && (c->d_type != DT_LNK || opts->no_follow);
+}
+
+// 按 skip_entry 删掉子项；known_only 时只看目录项已给出类型的，其余等 stat 之后再看
+static void prune_children(WalkNode *node, void *dir_ctx, WalkOptions *opts, int known_only) {
+    int kept = 0;
+    for (int i = 0; i < node->child_count; i++) {
+        WalkNode *c = node->children[i];
+        int check = known_only ? type_known(opts, c) : !type_known(opts, c);
+        if (c->has_stat < 0 ||
+            (check && opts->skip_entry && opts->skip_entry(c->path, c->is_dir, dir_ctx, opts->ctx))) {
+            free(c->path);
+            free(c);
+            continue;
+        }
+        node->children[kept++] = c;
+    }
+    node->child_count = kept;
+}
+
+// 要 stat 的子项一次批量取：类型未知的（DT_UNKNOWN、要跟随的符号链接）要靠它判断是不是目录，
+// want_stat 时文件也取好交给 visit_file。取不到的子项报错并标记删除
+static void stat_children(Walk *w, int id, WalkNode *node, int fd) {
+    WalkOptions *opts = w->opts;
+    int want_stat = opts->want_stat;
+    int n = 0;
+    for (int i = 0; i < node->child_count; i++) {
+        WalkNode *c = node->children[i];
+        if (!type_known(opts, c) || (want_stat && c->d_type != DT_DIR)) n++;
+    }
+    if (n == 0) return;
+
+    WalkNode **need = malloc(n * sizeof(WalkNode *));
+    char **names = malloc(n * sizeof(char *));
+    struct stat *st = malloc(n * sizeof(struct stat));
+    int *errs = malloc(n * sizeof(int));
+    if (!need || !names || !st || !errs) {
+        free(need);
+        free(names);
+        free(st);
+        free(errs);
+        return;
+    }
+    n = 0;
+    for (int i = 0; i < node->child_count; i++) {
+        WalkNode *c = node->children[i];
+        if (!type_known(opts, c) || (want_stat && c->d_type != DT_DIR)) {
+            need[n] = c;
+            names[n] = (char *)c->name;
+            n++;
+        }
+    }
+    stat_batch_run(w->stats[id], fd, names, n, opts->no_follow ? AT_SYMLINK_NOFOLLOW : 0, st, errs);
+    for (int i = 0; i < n; i++) {
+        WalkNode *c = need[i];
+        if (errs[i] != 0) {
+            errno = errs[i];
+            perror(c->path);
+            c->has_stat = -1;
+            continue;
+        }
+        c->is_dir = S_ISDIR(st[i].st_mode);
+        // 已经取到的元数据都留给 visit_file，类型未知的条目也能靠它判断类型
+        if (!c->is_dir) {
+            c->st = st[i];
+            c->has_stat = 1;
+        }
+    }
+    free(need);
+    free(names);
+    free(st);
+    free(errs);
+}
+
+// 目录本身交给 visit_dir，输出排在它的子项之前
+static void visit_dir(Walk *w, int id, WalkNode *node, int dirfd, const char *name,
+                      const struct stat *st) {
+    FILE *out = open_memstream(&node->output, &node->output_len);
+    if (!out) {
+        perror("open_memstream");
+        return;
+    }
+    WalkEntry entry = {node->path, dirfd, name, st, DT_DIR};
+    node->weight = w->opts->visit_dir(&entry, out, w->opts->ctx, id);
+    fclose(out);
+}
+
+// 列出目录：子项按名字排序，逆序入队，使本线程先取到第一个子项
+static void expand_dir(Walk *w, int id, WalkNode *node) {
+    int at = node->parent ? node->parent->fd : AT_FDCWD;
+    int fd = openat(at, node->name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        int err = errno;
+        // 打不开（比如没有权限）的目录，visit_dir 仍要看到它本身
+        struct stat st;
+        if (w->opts->visit_dir && fstatat(at, node->name, &st, 0) == 0) {
+            visit_dir(w, id, node, at, node->name, &st);
+        }
+        release_parent(node);
+        errno = err;
+        perror(node->path);
+        return;
+    }
+    release_parent(node);
+    struct stat dir_st;
+    int have_st = fstat(fd, &dir_st) == 0;
+    if (have_st) {
+        node->dev = dir_st.st_dev;
+        node->ino = dir_st.st_ino;
+        if (is_loop(node)) {
+            fprintf(stderr, "%s: recursive directory loop, skipped\n", node->path);
+            close(fd);
+            return;
+        }
+    }
+    if (w->opts->visit_dir) visit_dir(w, id, node, fd, ".", have_st ? &dir_st : NULL);
+    // 目录读取器有自己的描述符，fd 留给子项
+    DirReader *dir = dir_open(fd, ".");
+    if (!dir) {
+        perror(node->path);
+        close(fd);
+        return;
+    }
+    node->fd = fd;
+    WalkOptions *opts = w->opts;
+    void *dir_ctx = opts->enter_dir ? opts->enter_dir(node->path, fd, node->dir_ctx, opts->ctx) : NULL;
+
+    int cap = 0;
+    const DirEntry *entry;
+    while ((entry = dir_next(dir)) != NULL) {
+        char *path;
+        if (asprintf(&path, "%s/%s", node->path, entry->name) < 0) continue;
+
+        WalkNode *child = node_new(path, entry->type == DT_DIR);
+        if (!child) continue;
+        child->d_type = entry->type;
+        child->dir_ctx = dir_ctx;
+        child->parent = node;
+        child->name = path + strlen(node->path) + 1;
+        if (node->child_count == cap) {
+            cap = cap ? cap * 2 : 16;
+            node->children = realloc(node->children, cap * sizeof(WalkNode *));
+        }
+        node->children[node->child_count++] = child;
+    }
+    if (dir_error(dir)) {
+        errno = dir_error(dir);
+        perror(node->path);
+    }
+    dir_close(dir);
+
+    prune_children(node, dir_ctx, opts, 1);
+    stat_children(w, id, node, fd);
+    prune_children(node, dir_ctx, opts, 0);
+
+    qsort(node->children, node->child_count, sizeof(WalkNode *), compare_nodes);
+    atomic_store(&node->fd_users, node->child_count);
+    if (node->child_count == 0) {
+        close(fd);
+        node->fd = -1;
+    }
+    atomic_fetch_add(&w->pending, node->child_count);
+    for (int i = node->child_count - 1; i >= 0; i--) {
+        deque_push(w, id, node->children[i]);
+    }
+}
+
+static void visit_file(Walk *w, int id, WalkNode *node) {
+    FILE *out = open_memstream(&node->output, &node->output_len);
+    if (!out) {
+        perror("open_memstream");
+        release_parent(node);
+        return;
+    }
+    WalkEntry entry = {node->path, node->parent->fd, node->name,
+                       node->has_stat > 0 ? &node->st : NULL, node->d_type};
+    node->weight = w->opts->visit_file(&entry, out, w->opts->ctx, id);
+    fclose(out);
+    release_parent(node);
+}
+
+static void *worker_main(void *arg) {
+    WalkWorker *ww = arg;
+    Walk *w = ww->walk;
+    WalkNode *node;
+    while ((node = next_task(w, ww->id)) != NULL) {
+        if (node->is_dir) {
+            expand_dir(w, ww->id, node);
+        } else {
+            visit_file(w, ww->id, node);
+        }
+        node_finish(w, node);
+    }
+    return NULL;
+}
+
+// 输出线程：按树的顺序等待每个节点完成，文件输出整体写出，保证连续且顺序固定。
+// 返回整棵子树的 weight 之和，目录在子项都输出后交给 leave_dir
+static long long drain_node(Walk *w, WalkNode *node) {
+    pthread_mutex_lock(&w->lock);
+    w->waiting = node;
+    while (!node->done) {
+        pthread_cond_wait(&w->done_cond, &w->lock);
+    }
+    w->waiting = NULL;
+    pthread_mutex_unlock(&w->lock);
+
+    if (node->output_len > 0) {
+        fwrite(node->output, 1, node->output_len, stdout);
+    }
+    long long total = node->weight;
+    if (!node->is_dir && w->opts->drain_file) {
+        // 目录的 fd 此时可能已关闭，只给路径和元数据
+        WalkEntry entry = {node->path, -1, node->name, node->has_stat > 0 ? &node->st : NULL,
+                           node->d_type};
+        total = w->opts->drain_file(&entry, node->weight, w->opts->ctx);
+    }
+    for (int i = 0; i < node->child_count; i++) {
+        total += drain_node(w, node->children[i]);
+    }
+    if (node->is_dir && w->opts->leave_dir) {
+        w->opts->leave_dir(node->path, total, w->opts->ctx);
+    }
+    free(node->output);
+    free(node->children);
+    free(node->path);
+    free(node);
+    return total;
+}
+
+void walk_tree(const char *root, WalkOptions *opts) {
+    Walk w;
+    w.opts = opts;
+    w.nthreads = opts->threads > 0 ? opts->threads : walk_default_threads();
+    if (w.nthreads > WALK_MAX_THREADS) w.nthreads = WALK_MAX_THREADS;
+    w.deques = calloc(w.nthreads, sizeof(WalkDeque));
+    w.stats = calloc(w.nthreads, sizeof(StatBatch *));
+    atomic_init(&w.queued, 0);
+    atomic_init(&w.pending, 1);
+    pthread_mutex_init(&w.lock, NULL);
+    pthread_cond_init(&w.work_cond, NULL);
+    pthread_cond_init(&w.done_cond, NULL);
+    w.waiting = NULL;
+    for (int i = 0; i < w.nthreads; i++) {
+        pthread_mutex_init(&w.deques[i].lock, NULL);
+        w.stats[i] = stat_batch_new();
+    }
+
+    WalkNode *top = node_new(strdup(root), 1);
+    deque_push(&w, 0, top);
+
+    pthread_t tids[WALK_MAX_THREADS];
+    WalkWorker workers[WALK_MAX_THREADS];
+    for (int i = 0; i < w.nthreads; i++) {
+        workers[i].walk = &w;
+        workers[i].id = i;
+        pthread_create(&tids[i], NULL, worker_main, &workers[i]);
+    }
+
+    fflush(stdout);
+    drain_node(&w, top);
+    fflush(stdout);
+
+    for (int i = 0; i < w.nthreads; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    for (int i = 0; i < w.nthreads; i++) {
+        pthread_mutex_destroy(&w.deques[i].lock);
+        free(w.deques[i].items);
+        stat_batch_free(w.stats[i]);
+    }
+    free(w.deques);
+    free(w.stats);
+    pthread_mutex_destroy(&w.lock);
+    pthread_cond_destroy(&w.work_cond);
+    pthread_cond_destroy(&w.done_cond);
+}
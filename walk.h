@@ -0,0 +1,48 @@
+#ifndef WALK_H
+#define WALK_H
+
+#include <stdio.h>
+#include <sys/stat.h>
+
+// 并行目录遍历：目录和文件都作为任务分给工作线程（各自一个双端队列，空闲时互相窃取），
+// 每个文件的输出先写进独立缓冲，再由调用线程按深度优先、文件名排序的顺序依次输出。
+// 每个目录记下 (st_dev, st_ino)，与祖先相同（符号链接成环）时不再进入
+// 遍历到的文件：dirfd 是所在目录已打开的描述符，name 相对于它，可直接 openat / fstatat；
+// path 是从根拼出来的完整路径，只用于输出；st 是已取到的元数据（want_stat 时总有），没有为 NULL；
+// d_type 是目录项给出的类型（DT_REG、DT_LNK 等），文件系统不提供时为 DT_UNKNOWN
+typedef struct {
+    const char *path;
+    int dirfd;
+    const char *name;
+    const struct stat *st;
+    unsigned char d_type;
+} WalkEntry;
+
+typedef struct {
+    int threads;
+    // 非 0 时展开目录就为所有文件批量取好元数据（见 statbatch.h），visit_file 不必再 stat
+    int want_stat;
+    // 非 0 时不跟随符号链接：链接本身作为文件交给 visit_file，元数据是链接自己的
+    int no_follow;
+    // 对每个非目录条目调用；worker 为工作线程编号，可用来取线程私有的数据。
+    // 返回值按目录累加后交给 leave_dir，不需要时返回 0
+    long long (*visit_file)(const WalkEntry *entry, FILE *out, void *ctx, int worker);
+    // 可选：每个目录（含根目录）打开后调用，输出排在其子项之前；entry->st 是目录自己的元数据
+    long long (*visit_dir)(const WalkEntry *entry, FILE *out, void *ctx, int worker);
+    // 可选：目录的子项都输出后在调用线程里调用，total 为整棵子树 visit_* 返回值之和，可直接写 stdout
+    void (*leave_dir)(const char *path, long long total, void *ctx);
+    // 可选：在调用线程里按输出顺序对每个非目录条目调用（在它的缓冲输出之后），可直接写 stdout；
+    // 返回值替换 visit_file 的返回值。结果要与线程调度无关的事（如 du 的硬链接只算一次）放在这里做
+    long long (*drain_file)(const WalkEntry *entry, long long weight, void *ctx);
+    // 可选：展开目录前调用，返回该目录的上下文；dirfd 是目录已打开的描述符，目录里的文件用 openat 相对它打开；
+    // parent 为上级目录的上下文，根目录时为 NULL
+    void *(*enter_dir)(const char *path, int dirfd, void *parent, void *ctx);
+    // 可选：返回非 0 时跳过该子项，被跳过的目录不会打开；dir_ctx 为所在目录的上下文
+    int (*skip_entry)(const char *path, int is_dir, void *dir_ctx, void *ctx);
+    void *ctx;
+} WalkOptions;
+
+int walk_default_threads(void);
+void walk_tree(const char *root, WalkOptions *w);
+
+#endif
@@ -0,0 +1,117 @@
+#include <string.h>
+#include <ctype.h>
+#include "wildcard.h"
+
+static int in_class(const char *name, size_t len, int c) {
+    static const struct {
+        const char *name;
+        int (*fn)(int);
+    } classes[] = {
+        {"alpha", isalpha}, {"digit", isdigit}, {"alnum", isalnum}, {"upper", isupper},
+        {"lower", islower}, {"space", isspace}, {"blank", isblank}, {"punct", ispunct},
+        {"print", isprint}, {"graph", isgraph}, {"cntrl", iscntrl}, {"xdigit", isxdigit},
+    };
+    for (size_t i = 0; i < sizeof(classes) / sizeof(classes[0]); i++) {
+        if (strlen(classes[i].name) == len && strncmp(classes[i].name, name, len) == 0) {
+            return classes[i].fn(c) != 0;
+        }
+    }
+    return 0;
+}
+
+// [...]：p 指向 '['，返回是否匹配，*end 为 ']' 之后；括号没有闭合返回 -1，'[' 按普通字符处理
+static int match_bracket(const char *p, int c, const char **end) {
+    const char *q = p + 1;
+    int negate = 0;
+    if (*q == '!' || *q == '^') {
+        negate = 1;
+        q++;
+    }
+    int matched = 0;
+    for (int first = 1; *q && (*q != ']' || first); first = 0) {
+        if (q[0] == '[' && q[1] == ':') {
+            const char *close = strstr(q + 2, ":]");
+            if (close) {
+                if (in_class(q + 2, close - (q + 2), c)) matched = 1;
+                q = close + 2;
+                continue;
+            }
+        }
+        if (*q == '\\' && q[1]) q++;
+        int lo = (unsigned char)*q++;
+        int hi = lo;
+        if (q[0] == '-' && q[1] && q[1] != ']') {
+            q++;
+            if (*q == '\\' && q[1]) q++;
+            hi = (unsigned char)*q++;
+        }
+        if (c >= lo && c <= hi) matched = 1;
+    }
+    if (*q != ']') return -1;
+    *end = q + 1;
+    return matched != negate;
+}
+
+int wildcard_match(const char *p, const char *s, int flags) {
+    int pathname = flags & WILDCARD_PATHNAME;
+    while (*p) {
+        switch (*p) {
+        case '?':
+            if (!*s || (pathname && *s == '/')) return 0;
+            p++;
+            s++;
+            break;
+        case '*':
+            if (pathname && p[1] == '*') {
+                while (*p == '*') p++;
+                if (*p == '\0') return 1;            // 结尾的 **：其下所有内容
+                if (*p == '/') {
+                    // "**/"：跳过零层或多层目录
+                    p++;
+                    while (1) {
+                        if (wildcard_match(p, s, flags)) return 1;
+                        s = strchr(s, '/');
+                        if (!s) return 0;
+                        s++;
+                    }
+                }
+                // 其他位置的 ** 可以跨越 '/'
+                for (;; s++) {
+                    if (wildcard_match(p, s, flags)) return 1;
+                    if (!*s) return 0;
+                }
+            }
+            while (*p == '*') p++;
+            if (*p == '\0') return !pathname || strchr(s, '/') == NULL;
+            for (;; s++) {
+                if (wildcard_match(p, s, flags)) return 1;
+                if (!*s || (pathname && *s == '/')) return 0;
+            }
+        case '[': {
+            if (!*s || (pathname && *s == '/')) return 0;
+            const char *end;
+            int r = match_bracket(p, (unsigned char)*s, &end);
+            if (r >= 0) {
+                if (!r) return 0;
+                p = end;
+                s++;
+                break;
+            }
+            // 没有闭合的 '['：当普通字符
+            if (*s != '[') return 0;
+            p++;
+            s++;
+            break;
+        }
+        case '\\':
+            if (p[1]) p++;
+            // fall through
+        default:
+            if (*p != *s) return 0;
+            p++;
+            s++;
+            break;
+        }
+    }
+    return *s == '\0';
+}
@@ -0,0 +1,11 @@
+#ifndef WILDCARD_H
+#define WILDCARD_H
+
+// 通配符匹配：shell 展开 * ? [...] 和 grep -r 的忽略规则共用。
+// 行为同 fnmatch；带 WILDCARD_PATHNAME 时 * ? [...] 不匹配 '/'，
+// 并支持 gitignore 的 **（"**/" 匹配任意层目录，结尾的 "/**" 匹配其下所有内容）
+#define WILDCARD_PATHNAME 1
+
+int wildcard_match(const char *pattern, const char *string, int flags);
+
+#endif
@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#include "zread.h"
+
+#define Z_IN_SIZE (128 * 1024)
+
+struct ZReader {
+    int fd;
+    int format;
+    unsigned char *in;      // 压缩数据的输入缓冲
+    size_t in_pos, in_len;
+    int in_eof;
+    int finished;           // 最后一个压缩帧已结束且没有更多输入
+    const char *error;
+#ifdef HAVE_ZLIB
+    z_stream zs;
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD_DStream *zd;
+    int frame_done;         // 上一次解压恰好结束了一帧
+#endif
+};
+
+int z_detect(const unsigned char *head, size_t len) {
+#ifdef HAVE_ZLIB
+    if (len >= 2 && head[0] == 0x1f && head[1] == 0x8b) return Z_FORMAT_GZIP;
+#endif
+#ifdef HAVE_ZSTD
+    if (len >= 4 && head[0] == 0x28 && head[1] == 0xb5 && head[2] == 0x2f && head[3] == 0xfd) {
+        return Z_FORMAT_ZSTD;
+    }
+#endif
+    (void)head;
+    (void)len;
+    return Z_FORMAT_NONE;
+}
+
+ZReader *z_open(int fd, int format) {
+    ZReader *z = calloc(1, sizeof(ZReader));
+    if (!z) return NULL;
+    z->fd = fd;
+    z->format = format;
+    z->in = malloc(Z_IN_SIZE);
+    if (!z->in) {
+        free(z);
+        return NULL;
+    }
+
+    int ok = 0;
+#ifdef HAVE_ZLIB
+    if (format == Z_FORMAT_GZIP) {
+        // 16 + MAX_WBITS：只接受 gzip 头
+        ok = inflateInit2(&z->zs, 16 + MAX_WBITS) == Z_OK;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if (format == Z_FORMAT_ZSTD) {
+        z->zd = ZSTD_createDStream();
+        ok = z->zd && !ZSTD_isError(ZSTD_initDStream(z->zd));
+    }
+#endif
+    if (!ok) {
+        free(z->in);
+        free(z);
+        errno = ENOMEM;
+        return NULL;
+    }
+    return z;
+}
+
+#if defined(HAVE_ZLIB) || defined(HAVE_ZSTD)
+// 输入缓冲用完时从文件补充；返回 -1 为读错误
+static int z_fill(ZReader *z) {
+    if (z->in_pos < z->in_len || z->in_eof) return 0;
+    ssize_t n = read(z->fd, z->in, Z_IN_SIZE);
+    if (n < 0) {
+        z->error = strerror(errno);
+        return -1;
+    }
+    z->in_pos = 0;
+    z->in_len = n;
+    if (n == 0) z->in_eof = 1;
+    return 0;
+}
+#endif
+
+#ifdef HAVE_ZLIB
+static ssize_t gzip_read(ZReader *z, char *buf, size_t len) {
+    z->zs.next_out = (unsigned char *)buf;
+    z->zs.avail_out = len;
+    while (z->zs.avail_out == len && !z->finished) {
+        if (z_fill(z) != 0) return -1;
+        // 输入读完后解压器里仍可能有待输出的数据，照样调用 inflate
+        int no_input = z->in_pos == z->in_len;
+        z->zs.next_in = z->in + z->in_pos;
+        z->zs.avail_in = z->in_len - z->in_pos;
+        int ret = inflate(&z->zs, Z_NO_FLUSH);
+        z->in_pos = z->in_len - z->zs.avail_in;
+        if (ret == Z_STREAM_END) {
+            // 多个 gzip 成员首尾相接（如 cat a.gz b.gz）时接着解下一个
+            if (z_fill(z) != 0) return -1;
+            if (z->in_pos == z->in_len) z->finished = 1;
+            else inflateReset(&z->zs);
+        } else if (ret == Z_BUF_ERROR && no_input) {
+            z->error = "unexpected end of compressed data";
+            return -1;
+        } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            z->error = z->zs.msg ? z->zs.msg : "invalid compressed data";
+            return -1;
+        }
+    }
+    return len - z->zs.avail_out;
+}
+#endif
+
+#ifdef HAVE_ZSTD
+static ssize_t zstd_read(ZReader *z, char *buf, size_t len) {
+    ZSTD_outBuffer out = {buf, len, 0};
+    while (out.pos == 0 && !z->finished) {
+        if (z_fill(z) != 0) return -1;
+        int no_input = z->in_pos == z->in_len;
+        if (no_input && z->frame_done) {
+            z->finished = 1;
+            break;
+        }
+        ZSTD_inBuffer in = {z->in, z->in_len, z->in_pos};
+        size_t ret = ZSTD_decompressStream(z->zd, &out, &in);
+        z->in_pos = in.pos;
+        if (ZSTD_isError(ret)) {
+            z->error = ZSTD_getErrorName(ret);
+            return -1;
+        }
+        // 返回 0 表示一帧刚好解完，后面可能还有下一帧
+        z->frame_done = (ret == 0);
+        if (no_input && out.pos == 0 && !z->frame_done) {
+            z->error = "unexpected end of compressed data";
+            return -1;
+        }
+    }
+    return out.pos;
+}
+#endif
+
+ssize_t z_read(ZReader *z, char *buf, size_t len) {
+    if (z->finished || len == 0) return 0;
+#ifdef HAVE_ZLIB
+    if (z->format == Z_FORMAT_GZIP) return gzip_read(z, buf, len);
+#endif
+#ifdef HAVE_ZSTD
+    if (z->format == Z_FORMAT_ZSTD) return zstd_read(z, buf, len);
+#endif
+    (void)buf;
+    return 0;
+}
+
+const char *z_error(const ZReader *z) {
+    return z->error ? z->error : "invalid compressed data";
+}
+
+void z_close(ZReader *z) {
+    if (!z) return;
+#ifdef HAVE_ZLIB
+    if (z->format == Z_FORMAT_GZIP) inflateEnd(&z->zs);
+#endif
+#ifdef HAVE_ZSTD
+    if (z->format == Z_FORMAT_ZSTD) ZSTD_freeDStream(z->zd);
+#endif
+    free(z->in);
+    free(z);
+}
@@ -0,0 +1,22 @@
+#ifndef ZREAD_H
+#define ZREAD_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+// 压缩文件的流式解压读取：grep 按魔数识别 gzip / zstd，边解压边匹配，不落临时文件。
+// 对应的库（zlib、libzstd）在编译时检测到才支持，见 Makefile
+enum { Z_FORMAT_NONE, Z_FORMAT_GZIP, Z_FORMAT_ZSTD };
+
+typedef struct ZReader ZReader;
+
+// 根据文件开头的字节判断格式；不是压缩文件或本次编译不支持该格式时返回 Z_FORMAT_NONE
+int z_detect(const unsigned char *head, size_t len);
+// fd 应位于压缩流的开头
+ZReader *z_open(int fd, int format);
+// 读出解压后的数据，返回字节数，0 为结束，-1 为出错（原因见 z_error）
+ssize_t z_read(ZReader *z, char *buf, size_t len);
+const char *z_error(const ZReader *z);
+void z_close(ZReader *z);
+
+#endif